@@ -109,8 +109,17 @@ consoleread(int user_dst, uint64 dst, int n)
 
     // copy the input byte to the user-space buffer.
     cbuf = c;
-    if(either_copyout(user_dst, dst, &cbuf, 1) == -1)
-      break;
+    if(either_copyout(user_dst, dst, &cbuf, 1) == -1){
+      // + DEISO - P3
+      // Another thread of ours may have the page; fault it in
+      // without the lock and try again. See uvmaccess().
+      release(&cons.lock);
+      int ok = uvmprefault(myproc()->pagetable, dst, 1, 1) == 0;
+      acquire(&cons.lock);
+      if(!ok || either_copyout(user_dst, dst, &cbuf, 1) == -1)
+        break;
+      // - DEISO - P3
+    }
 
     dst++;
     --n;
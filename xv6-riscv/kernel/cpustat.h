@@ -0,0 +1,23 @@
+// + DEISO - P3
+#ifndef _CPUSTAT_H_
+#define _CPUSTAT_H_
+
+#include "types.h"
+#include "param.h"
+
+// How each hart spent its time, see getcpustat(). Times are in
+// r_time() cycles, TIMEBASE to the second; what a hart spent
+// in none of utime, stime and idle went to scheduler().
+struct cpustat {
+  uint64 now;         // r_time() when taken
+  struct {
+    int online;       // the hart has entered scheduler()
+    uint ticks;       // timer ticks it has taken
+    uint64 utime;     // running processes in user space
+    uint64 stime;     // running processes in the kernel
+    uint64 idle;      // waiting in wfi
+  } cpu[NCPU];
+};
+
+#endif // _CPUSTAT_H_
+// - DEISO - P3
@@ -16,6 +16,13 @@ struct superblock;
 struct pstat;
 // - DEISO - P1
 
+// + DEISO - P3
+struct mstat;
+struct gstat;
+struct cpustat;
+struct procquery;
+// - DEISO - P3
+
 // + DEISO - P2
 enum vma_type;
 struct vma;
@@ -83,6 +90,11 @@ void            incref(void *pa);
 uint             getref(void *pa);
 // - DEISO - P2
 
+// + DEISO - P3
+void            kput(void **, void *);
+void            kfreebatch(void *);
+// - DEISO - P3
+
 // log.c
 void            initlog(int, struct superblock*);
 void            log_write(struct buf*);
@@ -130,6 +142,32 @@ void            procdump(void);
 int getpinfo(struct pstat *pstat);
 // - DEISO - P1
 
+// + DEISO - P3
+extern struct pstat pstat;
+extern struct sleeplock pstatlock;
+int getmstat(int pid, struct mstat *mstat);
+void settickets(int tickets);
+void setrtprio(int prio);
+int needtick(void);
+int mkgroup(int tickets);
+int getgstat(int gid, struct gstat *gstat);
+int clone(uint64 fn, uint64 arg, uint64 stack);
+int join(int tid);
+pagetable_t proc_sharepagetable(struct proc *p, pagetable_t pagetable);
+int vmlock(struct proc *p);
+void vmunlock(struct proc *p);
+void tlback(struct proc *p);
+int tlbshootdown(pagetable_t pagetable);
+void tlbput(pagetable_t pagetable, void *pa);
+void* futexchan(uint64 va, uint64 pa, int shared);
+int futexwait(void *chan, uint64 va, int val);
+int futexwake(void *chan, int n);
+int setaffinity(int pid, uint64 mask);
+void cpuacct(struct proc *p, int touser);
+void getcpustat(struct cpustat *st);
+int procstat(struct procquery *q, uint64 buf, int n);
+// - DEISO - P3
+
 // swtch.S
 void            swtch(struct context*, struct context*);
 
@@ -140,6 +178,9 @@ void            initlock(struct spinlock*, char*);
 void            release(struct spinlock*);
 void            push_off(void);
 void            pop_off(void);
+// + DEISO - P3
+int             irqstat(uint64, int);
+// - DEISO - P3
 
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
@@ -170,6 +211,22 @@ void            trapinit(void);
 void            trapinithart(void);
 extern struct spinlock tickslock;
 void            usertrapret(void);
+// + DEISO - P3
+void            tickupdate(void);
+void            clockarm(void);
+void            clockslice(uint64);
+void            clockidle(void);
+void            clockbusy(void);
+void            ipi_send(int);
+// - DEISO - P3
+
+// + DEISO - P3
+// timer.c
+void            timerinit(void);
+int             timersleep(uint64);
+int             timerexpire(uint64, uint64 *);
+uint64          timernext(void);
+// - DEISO - P3
 
 // uart.c
 void            uartinit(void);
@@ -201,6 +258,16 @@ int             copyinstr(pagetable_t, char *, uint64, uint64);
 int copy_on_write(pagetable_t p, uint64 addr);
 // - DEISO - P2
 
+// + DEISO - P3
+void            uvmswitch(pagetable_t);
+void            uvmflush(pagetable_t);
+uint64          uaccess_fixup(uint64);
+void            uvmcount(pagetable_t, int, uint64 *, uint64 *);
+uint64          uvmphys(pagetable_t, uint64, int *);
+int             uvmload(pagetable_t, uint64, int *);
+int             uvmprefault(pagetable_t, uint64, uint64, int);
+// - DEISO - P3
+
 // plic.c
 void            plicinit(void);
 void            plicinithart(void);
@@ -218,7 +285,7 @@ void            virtio_disk_intr(void);
 // + DEISO - P2
 uint64 *create_vma_program(struct mm *, uint64, uint64, struct inode *,uint64 , uint64, int, int);
 uint64 *create_vma_file(struct mm *, uint64, struct file *, uint64, int, int);
-uint64 *create_vma_stack(struct mm*, uint64, uint64, int, int);
+uint64 *create_vma_stack(struct mm*, uint64, uint64, uint64, int, int);
 int alloc_vma(struct mm *, pagetable_t, uint64);
 int delete_vma(struct mm *, pagetable_t, uint64, uint64);
 struct vma *find_vma(struct mm *, uint64);
@@ -34,6 +34,13 @@ exec(char *path, char **argv)
   pagetable_t pagetable = 0, oldpagetable;
   struct proc *p = myproc();
 
+  // + DEISO - P3
+  // The new image would pull the memory out from under any
+  // other thread, so they must all have been joined.
+  if(p->vs->ref > 1)
+    return -1;
+  // - DEISO - P3
+
   begin_op();
 
   if((ip = namei(path)) == 0){
@@ -86,18 +93,24 @@ exec(char *path, char **argv)
   end_op();
   ip = 0;
 
-  p = myproc();
-  uint64 oldsz = p->sz;
+  // + DEISO - P3
+  uint64 oldsz = p->vs->sz;
+  // - DEISO - P3
 
-  // Allocate some pages at the next page boundary.
-  // Make the first inaccessible as a stack guard.
-  // Use the rest as the user stack.
-  sz = PGROUNDUP(sz);
+  // + DEISO - P3
+  // Leave an unmapped stack guard page at the next page boundary,
+  // then reserve p->stacklimit pages for a STACK vma that
+  // alloc_vma() grows down on demand. Only the top USERSTACK
+  // pages are allocated now, to hold the arguments.
+  sz = PGROUNDUP(sz) + PGSIZE + (uint64)p->stacklimit*PGSIZE;
   uint64 sz1;
-  if((sz1 = uvmalloc(pagetable, sz, sz + (USERSTACK+1)*PGSIZE, PTE_W)) == 0)
+  if((sz1 = uvmalloc(pagetable, sz - USERSTACK*PGSIZE, sz, PTE_W)) == 0)
+    goto bad;
+  if(create_vma_stack(new, sz - USERSTACK*PGSIZE, USERSTACK*PGSIZE,
+                      (uint64)p->stacklimit*PGSIZE, PTE_R | PTE_W, MAP_PRIVATE) == (uint64 *) -1)
     goto bad;
   sz = sz1;
-  uvmclear(pagetable, sz-(USERSTACK+1)*PGSIZE);
+  // - DEISO - P3
   sp = sz;
   stackbase = sp - USERSTACK*PGSIZE;
 
@@ -137,16 +150,31 @@ exec(char *path, char **argv)
   // Commit to the user image.
 
   // + DEISO - P2 
-  mm_destroy(&p->mm, p->pagetable);
-  mm_copy(new, &p->mm);
+  mm_destroy(p->mm, p->pagetable);
+  mm_copy(new, p->mm);
   kfree(new);
   // - DEISO - P2
 
+  // + DEISO - P3
+  // getmstat() walks p->pagetable holding p->lock.
+  acquire(&p->lock);
   oldpagetable = p->pagetable;
   p->pagetable = pagetable;
-  p->sz = sz;
+  release(&p->lock);
+  p->vs->sz = sz;
+  // - DEISO - P3
   p->trapframe->epc = elf.entry;  // initial program counter = main
   p->trapframe->sp = sp; // initial stack pointer
+  // + DEISO - P3
+  uvmflush(pagetable);
+  // proc_pagetable() put our trapframe in slot 0, which a
+  // thread left alone by the others may not have had.
+  if(p->tslot != 0){
+    uvmunmap(oldpagetable, TRAPFRAMES(p->tslot), 1, 0);
+    p->tslot = 0;
+    p->vs->tslots = 1;
+  }
+  // - DEISO - P3
   proc_freepagetable(oldpagetable, oldsz);
 
   return argc; // this ends up in a0, the first argument to main(argc, argv)
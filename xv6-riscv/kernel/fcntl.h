@@ -19,4 +19,10 @@
 #define MAP_PRIVATE (1 << 1)
 // - DEISO - P2
 
+// + DEISO - P3
+// futex() operations.
+#define FUTEX_WAIT 0
+#define FUTEX_WAKE 1
+// - DEISO - P3
+
 #endif // _FCNTL_H_
\ No newline at end of file
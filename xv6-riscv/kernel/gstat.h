@@ -0,0 +1,17 @@
+// + DEISO - P3
+#ifndef _GSTAT_H_
+#define _GSTAT_H_
+
+#include "types.h"
+
+// Usage of a ticket group, see mkgroup() and getgstat().
+struct gstat {
+  int gid;
+  int tickets;      // base tickets that fund the group
+  int members;      // processes in the group
+  int active;       // tickets of RUNNABLE and RUNNING members, in the group's currency
+  uint64 ticks;     // times a member was picked to run
+};
+
+#endif // _GSTAT_H_
+// - DEISO - P3
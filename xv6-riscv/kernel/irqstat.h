@@ -0,0 +1,29 @@
+// + DEISO - P3
+#ifndef _IRQSTAT_H_
+#define _IRQSTAT_H_
+
+#include "types.h"
+#include "param.h"
+
+// What make IRQTRACE=1 records of the stretches each hart spends
+// with interrupts off under push_off(), see irqstat().
+#define NIRQHIST  16  // histogram buckets
+#define NIRQWORST 8   // worst callers kept per hart
+
+struct irqcpu {
+  // stretches of 2^i to 2^(i+1) us in hist[i]; hist[0] also has
+  // the shorter ones, and the last bucket the longer ones.
+  uint64 hist[NIRQHIST];
+  struct {
+    uint64 pc;        // who turned interrupts off, 0 if unused
+    uint64 cycles;    // its longest stretch, in r_time() cycles
+    char lock[16];    // the lock it took, if through acquire()
+  } worst[NIRQWORST];
+};
+
+struct irqstat {
+  struct irqcpu cpu[NCPU];
+};
+
+#endif // _IRQSTAT_H_
+// - DEISO - P3
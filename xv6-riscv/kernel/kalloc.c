@@ -142,10 +142,12 @@ incref(void *pa)
   if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
     panic("incref");
 
-  acquire(&kmem.lock);
+  // + DEISO - P3
+  // Reference counts are updated atomically, so that kput() can
+  // drop references without taking kmem.lock.
   r = &kmem.runs[(uint64)pa / PGSIZE];
-  r->ref++;
-  release(&kmem.lock);
+  __sync_fetch_and_add(&r->ref, 1);
+  // - DEISO - P3
 }
 
 /**
@@ -159,10 +161,10 @@ decref(void *pa)
   if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
     panic("decref");
 
-  acquire(&kmem.lock);
+  // + DEISO - P3
   r = &kmem.runs[(uint64)pa / PGSIZE];
-  r->ref--;
-  release(&kmem.lock);
+  __sync_fetch_and_sub(&r->ref, 1);
+  // - DEISO - P3
 }
 
 /**
@@ -184,3 +186,55 @@ printref(char *pa)
   struct run *r = &kmem.runs[(uint64)pa / PGSIZE];
   printf("printref: address: 0x%p, ref: %d\n", r, r->ref);
 }
+
+
+// + DEISO - P3
+/**
+ * Drop a reference to page pa. If it was the last one, chain the
+ * page onto *batch, which must start out as 0, instead of freeing
+ * it right away; kfreebatch() then frees the whole chain.
+ */
+void
+kput(void **batch, void *pa)
+{
+  struct run *r;
+
+  if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
+    panic("kput");
+
+  r = &kmem.runs[(uint64)pa / PGSIZE];
+  if(__sync_sub_and_fetch(&r->ref, 1) != 0)
+    return;
+  r->next = *batch;
+  *batch = r;
+}
+
+/**
+ * Give a chain of pages built by kput() back to the allocator,
+ * taking kmem.lock once for all of them.
+ */
+void
+kfreebatch(void *batch)
+{
+  struct run *head = batch, *tail;
+
+  if(head == 0)
+    return;
+
+  for(tail = head; ; tail = tail->next){
+#ifndef NDEBUG
+    // Fill with junk to catch dangling refs.
+    memset((char*)((tail - kmem.runs) * PGSIZE), 1, PGSIZE);
+#endif
+    // Pages on the free list keep a count of one, like kfree().
+    tail->ref = 1;
+    if(tail->next == 0)
+      break;
+  }
+
+  acquire(&kmem.lock);
+  tail->next = kmem.freelist;
+  kmem.freelist = head;
+  release(&kmem.lock);
+}
+// - DEISO - P3
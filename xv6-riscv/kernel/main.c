@@ -21,6 +21,9 @@ main()
     kvminithart();   // turn on paging
     procinit();      // process table
     trapinit();      // trap vectors
+    // + DEISO - P3
+    timerinit();     // deadline queues for timed sleep
+    // - DEISO - P3
     trapinithart();  // install kernel trap vector
     plicinit();      // set up interrupt controller
     plicinithart();  // ask PLIC for device interrupts
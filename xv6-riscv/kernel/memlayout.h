@@ -8,6 +8,7 @@
 //
 // 00001000 -- boot ROM, provided by qemu
 // 02000000 -- CLINT
+// 02F00000 -- ACLINT SSWI, with -machine virt,aclint=on
 // 0C000000 -- PLIC
 // 10000000 -- uart0 
 // 10001000 -- virtio disk 
@@ -36,6 +37,16 @@
 #define PLIC_SPRIORITY(hart) (PLIC + 0x201000 + (hart)*0x2000)
 #define PLIC_SCLAIM(hart) (PLIC + 0x201004 + (hart)*0x2000)
 
+// + DEISO - P3
+// qemu -machine virt,aclint=on puts the ACLINT supervisor
+// software interrupt device here: writing 1 to a hart's
+// register raises a supervisor software interrupt on it.
+// Only used with make IPI=1.
+#define SSWI 0x02F00000L
+#define SSWI_SIZE 0x4000
+#define SSWI_SETSSIP(hart) (SSWI + 4*(hart))
+// - DEISO - P3
+
 // the kernel expects there to be RAM
 // for use by the kernel and user pages
 // from physical address 0x80000000 to PHYSTOP.
@@ -61,4 +72,18 @@
 //   TRAMPOLINE (the same page as in the kernel)
 #define TRAPFRAME (TRAMPOLINE - PGSIZE)
 
+// + DEISO - P3
+// with UACCESS_SUM, each hart's kernel page table maps the user
+// space of the process it is running a second time, in the upper
+// half of the Sv39 address space, which the kernel does not use
+// otherwise. user address va is reachable at USERALIAS + va.
+#define USERALIAS 0xffffffc000000000L
+
+// threads made by clone() share one page table, so each maps its
+// trapframe in its own slot below TRAMPOLINE: slot 0 is TRAPFRAME.
+// user memory ends below the lowest slot, at USERTOP.
+#define TRAPFRAMES(t) (TRAPFRAME - (uint64)(t)*PGSIZE)
+#define USERTOP TRAPFRAMES(NTHREAD - 1)
+// - DEISO - P3
+
 #endif // _MEMLAYOUT_H_
\ No newline at end of file
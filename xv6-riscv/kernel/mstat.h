@@ -0,0 +1,20 @@
+// + DEISO - P3
+#ifndef _MSTAT_H_
+#define _MSTAT_H_
+
+#include "types.h"
+
+// Page-fault and memory counters of a process, see getmstat().
+struct mstat {
+  int pid;
+  uint64 minflt;    // page faults served without reading a file
+  uint64 majflt;    // page faults that read the page from a file
+  uint64 cowcopy;   // copy-on-write faults that copied the page
+  uint64 cowreuse;  // copy-on-write faults that reused the page in place
+  uint64 writeback; // pages written back to files by munmap() and exit()
+  uint64 rss;       // resident user pages
+  uint64 shared;    // resident user pages shared with other processes
+};
+
+#endif // _MSTAT_H_
+// - DEISO - P3
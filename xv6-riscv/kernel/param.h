@@ -1,7 +1,11 @@
 #ifndef _PARAM_H_
 #define _PARAM_H_
 
-#define NPROC        64  // maximum number of processes
+// + DEISO - P3
+#ifndef NPROC
+#define NPROC        64  // maximum number of processes (make NPROC=n)
+#endif
+// - DEISO - P3
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
 #define NFILE       100  // open files per system
@@ -15,5 +19,23 @@
 #define FSSIZE       2000  // size of file system in blocks
 #define MAXPATH      128   // maximum file path name
 #define USERSTACK    1     // user stack pages
+// + DEISO - P3
+#define USERSTACKLIMIT 64  // default limit the user stack may grow to (pages)
+#define MAXUSERSTACK 1024  // largest stack limit a process may ask for (pages)
+#define MAXTICKETS (1<<20) // most tickets a process may hold
+#define NRTPRIO       4  // real-time priority levels above the normal band
+#define RTPERIOD     10  // ticks in a real-time throttling window
+#define RTRUNTIME     9  // ticks of each window a hart may give to real-time
+#define TIMEBASE 10000000  // r_time() cycles per second (qemu virt)
+#define QUANTUM (TIMEBASE/10) // timer cycles in a tick
+#ifndef SCHEDQUANTUM
+#define SCHEDQUANTUM QUANTUM  // default time slice, timer cycles (make SLICE=us)
+#endif
+#define MINQUANTUM (QUANTUM/20)  // shortest time slice
+#define MAXQUANTUM (QUANTUM*4)   // longest time slice; also the ADAPTIVE latency target
+#define IDLEPOLL     10  // ticks an idle hart sleeps before looking for work (TICKLESS)
+#define NGROUP       16  // ticket groups, including the base group 0
+#define NTHREAD      16  // threads that may share an address space
+// - DEISO - P3
 
 #endif // _PARAM_H_
\ No newline at end of file
@@ -89,11 +89,28 @@ pipewrite(struct pipe *pi, uint64 addr, int n)
       wakeup(&pi->nread);
       sleep(&pi->nwrite, &pi->lock);
     } else {
-      char ch;
-      if(copyin(pr->pagetable, &ch, addr + i, 1) == -1)
-        break;
-      pi->data[pi->nwrite++ % PIPESIZE] = ch;
-      i++;
+      // + DEISO - P3
+      // Copy as much as there is room for, up to the end of the
+      // ring, in one go rather than a byte at a time.
+      uint w = pi->nwrite % PIPESIZE;
+      uint m = n - i;
+      if(m > PIPESIZE - w)
+        m = PIPESIZE - w;
+      if(m > pi->nread + PIPESIZE - pi->nwrite)
+        m = pi->nread + PIPESIZE - pi->nwrite;
+      if(copyin(pr->pagetable, &pi->data[w], addr + i, m) == -1){
+        // Another thread of ours may have the pages; fault them
+        // in without the lock and try again. See uvmaccess().
+        release(&pi->lock);
+        int ok = uvmprefault(pr->pagetable, addr + i, m, 0) == 0;
+        acquire(&pi->lock);
+        if(!ok)
+          break;
+        continue;
+      }
+      pi->nwrite += m;
+      i += m;
+      // - DEISO - P3
     }
   }
   wakeup(&pi->nread);
@@ -107,9 +124,14 @@ piperead(struct pipe *pi, uint64 addr, int n)
 {
   int i;
   struct proc *pr = myproc();
-  char ch;
+  // + DEISO - P3
+  uint r, m;
+  // - DEISO - P3
 
   acquire(&pi->lock);
+  // + DEISO - P3
+again:
+  // - DEISO - P3
   while(pi->nread == pi->nwrite && pi->writeopen){  //DOC: pipe-empty
     if(killed(pr)){
       release(&pi->lock);
@@ -117,13 +139,30 @@ piperead(struct pipe *pi, uint64 addr, int n)
     }
     sleep(&pi->nread, &pi->lock); //DOC: piperead-sleep
   }
-  for(i = 0; i < n; i++){  //DOC: piperead-copy
+  // + DEISO - P3
+  // Copy out whole runs of the ring rather than a byte at a time.
+  for(i = 0; i < n; i += m){  //DOC: piperead-copy
     if(pi->nread == pi->nwrite)
       break;
-    ch = pi->data[pi->nread++ % PIPESIZE];
-    if(copyout(pr->pagetable, addr + i, &ch, 1) == -1)
+    r = pi->nread % PIPESIZE;
+    m = n - i;
+    if(m > PIPESIZE - r)
+      m = PIPESIZE - r;
+    if(m > pi->nwrite - pi->nread)
+      m = pi->nwrite - pi->nread;
+    if(copyout(pr->pagetable, addr + i, &pi->data[r], m) == -1){
+      // As in pipewrite(). Someone may have emptied the pipe
+      // meanwhile, so return what we have, or start over.
+      release(&pi->lock);
+      int ok = uvmprefault(pr->pagetable, addr + i, m, 1) == 0;
+      acquire(&pi->lock);
+      if(ok && i == 0)
+        goto again;
       break;
+    }
+    pi->nread += m;
   }
+  // - DEISO - P3
   wakeup(&pi->nwrite);  //DOC: piperead-wakeup
   release(&pi->lock);
   return i;
@@ -8,14 +8,21 @@
 
 // + DEISO - P1
 #include "pstat.h"
-
-#define MODULO 424967296
-#define MULTIPLICADOR 1664525
-#define INCREMENTO 1013904223
-#define SEMILLA 123456789
+// + DEISO - P3
+#include "gstat.h"
+#include "cpustat.h"
+#include "procinfo.h"
+#include "sleeplock.h"
+// - DEISO - P3
 
 struct pstat pstat;
 // - DEISO - P1
+// + DEISO - P3
+// struct pstat grows with NPROC and soon does not fit on a
+// kernel stack, so sys_getpinfo() fills in the one above,
+// under pstatlock.
+struct sleeplock pstatlock;
+// - DEISO - P3
 
 // + DEISO - P2
 #include "vma.h"
@@ -32,6 +39,13 @@ struct spinlock pid_lock;
 
 extern void forkret(void);
 static void freeproc(struct proc *p);
+// + DEISO - P3
+static void setrunnable(struct proc *p);
+static void vsswitch(struct proc *p);
+static void group_active(struct proc *p, int delta);
+static int procstart(struct proc *p, struct proc *np);
+static void kick(struct proc *p);
+// - DEISO - P3
 
 extern char trampoline[]; // trampoline.S
 
@@ -41,6 +55,1126 @@ extern char trampoline[]; // trampoline.S
 // must be acquired before any p->lock.
 struct spinlock wait_lock;
 
+// + DEISO - P3
+// Each process keeps its children on two lists, those still
+// running and those that have exited, so that wait() and
+// exit() only look at the caller's own children instead of
+// at every process. wait_lock protects the lists.
+
+// Put p at the front of the list at *head.
+static void
+kin_push(struct proc **head, struct proc *p)
+{
+  p->sibling = *head;
+  if(*head)
+    (*head)->psibling = &p->sibling;
+  *head = p;
+  p->psibling = head;
+}
+
+// Take p off whichever list it is on.
+static void
+kin_unlink(struct proc *p)
+{
+  *p->psibling = p->sibling;
+  if(p->sibling)
+    p->sibling->psibling = p->psibling;
+  p->sibling = 0;
+  p->psibling = 0;
+}
+// - DEISO - P3
+
+// + DEISO - P3
+// proc[] is a pool: UNUSED slots wait on a free list, so that
+// allocproc() takes one without a scan, and live processes
+// are hashed by pid, so that kill() and other lookups by pid
+// go straight to them. Slots never go away, so a lookup may
+// take the bucket lock, drop it and then lock the process,
+// as long as it checks the pid again under p->lock.
+// freelock and the bucket locks are acquired after p->lock.
+#define NPIDHASH 64
+
+struct spinlock freelock;
+struct proc *freeprocs;
+
+struct pidhash {
+  struct spinlock lock;
+  struct proc *head;
+} pidhash[NPIDHASH];
+
+static struct pidhash*
+pidhash_of(int pid)
+{
+  return &pidhash[(uint)pid % NPIDHASH];
+}
+
+static void
+pidhash_insert(struct proc *p)
+{
+  struct pidhash *h = pidhash_of(p->pid);
+
+  acquire(&h->lock);
+  p->pidnext = h->head;
+  h->head = p;
+  release(&h->lock);
+}
+
+static void
+pidhash_remove(struct proc *p)
+{
+  struct pidhash *h = pidhash_of(p->pid);
+  struct proc **pp;
+
+  acquire(&h->lock);
+  for(pp = &h->head; *pp; pp = &(*pp)->pidnext){
+    if(*pp == p){
+      *pp = p->pidnext;
+      break;
+    }
+  }
+  release(&h->lock);
+  p->pidnext = 0;
+}
+
+// Return the live process with the given pid, locked, or 0.
+static struct proc*
+findproc(int pid)
+{
+  struct pidhash *h = pidhash_of(pid);
+  struct proc *p;
+
+  acquire(&h->lock);
+  for(p = h->head; p && p->pid != pid; p = p->pidnext)
+    ;
+  release(&h->lock);
+  if(p == 0)
+    return 0;
+  acquire(&p->lock);
+  if(p->pid != pid || p->state == UNUSED){
+    release(&p->lock);
+    return 0;
+  }
+  return p;
+}
+// - DEISO - P3
+
+// + DEISO - P3
+// Sleep queues: processes sleeping on a chan are linked on the
+// queue that chan hashes to, so that wakeup() only looks at
+// them instead of at every process. q->lock protects the list
+// and, while p is on it, p->chan. It is acquired before p->lock.
+#define NSLEEPQ 64
+
+struct sleepq {
+  struct spinlock lock;
+  struct proc *head;
+} sleepq[NSLEEPQ];
+
+static struct sleepq*
+sleepq_of(void *chan)
+{
+  uint64 h = (uint64)chan;
+
+  h ^= h >> 12;
+  return &sleepq[(h >> 3) % NSLEEPQ];
+}
+
+// Take p off q if it is still there. Caller must hold q->lock.
+static void
+sleepq_remove(struct sleepq *q, struct proc *p)
+{
+  struct proc **pp;
+
+  for(pp = &q->head; *pp; pp = &(*pp)->sqnext){
+    if(*pp == p){
+      *pp = p->sqnext;
+      break;
+    }
+  }
+  p->sleepq = 0;
+}
+
+// Put p to sleep on chan, in q. Called with q->lock and
+// p->lock held; returns with neither.
+static void
+sleepq_sleep(struct sleepq *q, struct proc *p, void *chan)
+{
+  p->chan = chan;
+  p->state = SLEEPING;
+  group_active(p, -p->tickets);
+  p->sqnext = q->head;
+  q->head = p;
+  p->sleepq = q;
+  release(&q->lock);
+
+  sched();
+
+  // Tidy up. wakeup() took p off the queue, but kill() does
+  // not, so p may still be there.
+  release(&p->lock);
+  acquire(&q->lock);
+  if(p->sleepq)
+    sleepq_remove(q, p);
+  p->chan = 0;
+  release(&q->lock);
+}
+
+// Wake up to n processes sleeping on chan, or all of them if n
+// is negative. Returns how many it woke.
+static int
+sleepq_wake(void *chan, int n)
+{
+  struct sleepq *q = sleepq_of(chan);
+  struct proc *p, **pp;
+  int woke = 0;
+
+  acquire(&q->lock);
+  for(pp = &q->head; (p = *pp) != 0 && woke != n; ){
+    if(p->chan != chan){
+      pp = &p->sqnext;
+      continue;
+    }
+    *pp = p->sqnext;
+    p->sleepq = 0;
+    acquire(&p->lock);
+    if(p->state == SLEEPING){
+      setrunnable(p);
+      woke++;
+    }
+    release(&p->lock);
+  }
+  release(&q->lock);
+  return woke;
+}
+// - DEISO - P3
+
+// + DEISO - P3
+// Ticket groups. A process's tickets are in the currency of
+// its group p->group. Group g is funded with groups[g].tickets
+// base tickets, which are split among its active (RUNNABLE or
+// RUNNING) members in proportion to their own tickets, so a
+// group keeps its share however many processes it forks.
+// Group 0 is the base currency: it holds every process that
+// never called mkgroup(), whose tickets count at face value.
+// fork() inherits the group.
+// glock protects groups[] and is acquired after p->lock.
+struct group {
+  int members;           // processes in the group; slot free if 0
+  int tickets;           // funding, in base tickets
+  int active;            // tickets of active members, in this currency
+  uint64 ticks;          // times a member was picked to run
+} groups[NGROUP];
+struct spinlock glock;
+
+// p's tickets in the base currency, which is what the
+// schedulers weigh. Caller must hold p->lock. Reads the group
+// without glock: a stale value only skews a draw or two.
+#if defined(LOTERY_SCHED) || defined(STRIDE_SCHED)
+static int
+weightof(struct proc *p)
+{
+  struct group *g = &groups[p->group];
+  uint64 t = p->tickets + p->comp;
+
+  if(p->group == 0 || g->active <= 0)
+    return t;
+  t = t * g->tickets / g->active;
+  if(t < 1)
+    t = 1;
+  if(t > MAXTICKETS)
+    t = MAXTICKETS;
+  return t;
+}
+#endif
+
+// Add delta to the active tickets of p's group, as p starts
+// or stops competing. Caller must hold p->lock.
+static void
+group_active(struct proc *p, int delta)
+{
+  acquire(&glock);
+  groups[p->group].active += delta;
+  release(&glock);
+}
+
+// Move p from group from to group to, which may be -1 for
+// none. An active p takes its tickets along.
+// Caller must hold p->lock and glock.
+static void
+group_move(struct proc *p, int from, int to)
+{
+  int active = p->state == RUNNABLE || p->state == RUNNING;
+
+  if(from >= 0){
+    groups[from].members--;
+    if(active)
+      groups[from].active -= p->tickets;
+  }
+  if(to >= 0){
+    groups[to].members++;
+    if(active)
+      groups[to].active += p->tickets;
+    p->group = to;
+  }
+}
+// - DEISO - P3
+
+// + DEISO - P3
+#if defined(LOTERY_SCHED) && defined(STRIDE_SCHED)
+#error "LOTERY_SCHED and STRIDE_SCHED exclude each other"
+#endif
+#if defined(LOTERY_SCHED) || defined(STRIDE_SCHED)
+#define RUNQ_SCHED
+#endif
+
+#ifdef RUNQ_SCHED
+// Per-hart run queues for the proportional-share schedulers.
+// Each hart picks among the RUNNABLE processes on its own queue:
+// the lottery scheduler draws a random ticket out of a Fenwick
+// tree of tickets, the stride scheduler takes the least pass
+// out of a segment tree. Both trees are indexed by proc[] slot,
+// so a pick is O(log NPROC) under one lock. A process has
+// p->weight tickets on runq[p->cpu]: p->tickets while it is
+// RUNNABLE and 0 otherwise. p->cpu also remembers where p last
+// ran, and wakeup() puts it back on that queue.
+// Harts with less work steal from the busiest queue, if the
+// process drawn there may run on them (p->affinity).
+// A runq lock is acquired after p->lock.
+struct runq {
+  struct spinlock lock;
+  int total;             // sum of all weights
+  int n;                 // processes queued
+  int running;           // tickets of the process running on this hart
+  int online;            // this hart has entered scheduler()
+#ifdef STRIDE_SCHED
+  uint64 vtime;          // pass of the process picked last
+  uint64 pass[NPROC];    // pass of each queued slot, NOPASS if none
+  int tree[2*NPROC];     // slot with the least pass under each node
+#else
+  int tree[NPROC+1];     // 1-based Fenwick tree of weights
+#endif
+} runq[NCPU];
+
+// Next number of a hart's pseudo-random stream (xorshift64*).
+// Each hart seeds its own stream in scheduler(), so harts do
+// not draw the same sequence of tickets.
+static uint64
+lottery_rand(uint64 *state)
+{
+  uint64 x = *state;
+
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return (x * 0x2545F4914F6CDD1DUL) >> 32;
+}
+
+#ifdef STRIDE_SCHED
+// A process's pass advances by STRIDE1 / p->tickets each time it
+// is picked; STRIDE1 >= MAXTICKETS keeps every stride above 0.
+#define STRIDE1 (1UL << 20)
+#define NOPASS  (~0UL)
+
+static void
+runq_init(struct runq *rq)
+{
+  for(int i = 0; i < NPROC; i++){
+    rq->pass[i] = NOPASS;
+    rq->tree[NPROC + i] = i;
+  }
+  for(int i = NPROC - 1; i > 0; i--)
+    rq->tree[i] = rq->tree[2*i];
+}
+
+// Add delta to slot's weight, queueing the slot at its
+// process's pass or taking it off the queue.
+static void
+runq_add(struct runq *rq, int slot, int delta)
+{
+  rq->total += delta;
+  rq->n += delta > 0 ? 1 : -1;
+  rq->pass[slot] = delta > 0 ? proc[slot].pass : NOPASS;
+  for(int i = (NPROC + slot) / 2; i > 0; i /= 2){
+    int a = rq->tree[2*i], b = rq->tree[2*i + 1];
+    rq->tree[i] = rq->pass[a] <= rq->pass[b] ? a : b;
+  }
+}
+
+// Return the process with the least pass on rq, or 0 if rq is
+// empty; r is unused. The process is not locked, so the caller
+// must check that it is still RUNNABLE on rq once it holds
+// p->lock.
+static struct proc*
+runq_draw(struct runq *rq, uint64 r)
+{
+  struct proc *p = 0;
+
+  acquire(&rq->lock);
+  if(rq->total > 0)
+    p = &proc[rq->tree[1]];
+  release(&rq->lock);
+  return p;
+}
+#else
+static int runq_step;    // largest power of two <= NPROC
+
+static void
+runq_init(struct runq *rq)
+{
+  for(runq_step = 1; runq_step * 2 <= NPROC; runq_step *= 2)
+    ;
+}
+
+static void
+runq_add(struct runq *rq, int slot, int delta)
+{
+  rq->total += delta;
+  rq->n += delta > 0 ? 1 : -1;
+  for(int i = slot + 1; i <= NPROC; i += i & -i)
+    rq->tree[i] += delta;
+}
+
+// Return the slot that holds ticket r, 0 <= r < rq->total:
+// the first slot whose prefix sum of weights exceeds r.
+static int
+runq_find(struct runq *rq, int r)
+{
+  int i = 0;
+
+  for(int step = runq_step; step > 0; step >>= 1){
+    if(i + step <= NPROC && rq->tree[i + step] <= r){
+      i += step;
+      r -= rq->tree[i];
+    }
+  }
+  return i;
+}
+
+// Draw a ticket on rq and return its holder, or 0 if rq is
+// empty. The holder is not locked, so the caller must check
+// that it is still RUNNABLE on rq once it holds p->lock.
+static struct proc*
+runq_draw(struct runq *rq, uint64 r)
+{
+  struct proc *p = 0;
+
+  acquire(&rq->lock);
+  if(rq->total > 0)
+    p = &proc[runq_find(rq, r % rq->total)];
+  release(&rq->lock);
+  return p;
+}
+#endif
+
+// Put p's weight on the queue of hart cpu, bringing it up
+// to date with p->state. Caller must hold p->lock.
+static void
+runq_update(struct proc *p, int cpu)
+{
+  int w = p->state == RUNNABLE ? weightof(p) : 0;
+  int slot = p - proc;
+
+  if(w == p->weight && cpu == p->cpu)
+    return;
+#ifdef STRIDE_SCHED
+  // the queues' vtimes are read without their locks; they
+  // only need to be roughly current.
+  if(w && p->weight == 0){
+    // p was not waiting, so it must not have banked any
+    // time: start it no earlier than the queue's present.
+    if(p->pass < runq[cpu].vtime)
+      p->pass = runq[cpu].vtime;
+  } else if(w){
+    // moving between queues keeps p's lead or lag.
+    p->pass = p->pass - runq[p->cpu].vtime + runq[cpu].vtime;
+  }
+#endif
+  if(p->weight){
+    acquire(&runq[p->cpu].lock);
+    runq_add(&runq[p->cpu], slot, -p->weight);
+    release(&runq[p->cpu].lock);
+  }
+  if(w){
+    acquire(&runq[cpu].lock);
+    runq_add(&runq[cpu], slot, w);
+    release(&runq[cpu].lock);
+  }
+  p->weight = w;
+  p->cpu = cpu;
+}
+
+// p was queued while it ran, by yield(), before account()
+// settled its compensation or its pass: queue it again with
+// them, so the next draw already sees them. Caller must hold
+// p->lock.
+static void
+runq_requeue(struct proc *p)
+{
+  struct runq *rq = &runq[p->cpu];
+  int slot = p - proc;
+  int w;
+
+  if(p->state != RUNNABLE || p->weight == 0)
+    return;
+  w = weightof(p);
+  acquire(&rq->lock);
+  runq_add(rq, slot, -p->weight);
+  runq_add(rq, slot, w);
+  release(&rq->lock);
+  p->weight = w;
+}
+
+// Tickets waiting on or running from hart cpu. Peeks without
+// locks, so callers may only use it as a hint.
+static int
+runq_load(int cpu)
+{
+  return runq[cpu].total + runq[cpu].running;
+}
+
+// The online hart in mask with the least work, preferring cpu
+// on ties. mask must hold an online hart.
+static int
+runq_idlest(int cpu, uint64 mask)
+{
+  int best = (mask >> cpu) & 1 ? cpu : -1;
+
+  for(int i = 0; i < NCPU; i++){
+    if(runq[i].online && ((mask >> i) & 1) &&
+       (best < 0 || runq_load(i) < runq_load(best)))
+      best = i;
+  }
+  return best;
+}
+
+// If the busiest queue has more work than hart cpu's, move one
+// of its waiting processes over: always when cpu has nothing
+// waiting, otherwise only if that narrows the gap between the
+// two. Stealing a random ticket picks processes in proportion
+// to their tickets. Returns 1 if a process was stolen.
+static int
+runq_steal(int cpu, uint64 r)
+{
+  int victim = -1, most = 0, stolen = 0;
+  struct proc *p;
+
+  for(int i = 0; i < NCPU; i++){
+    if(i != cpu && runq[i].total > 0 && runq_load(i) > most){
+      victim = i;
+      most = runq_load(i);
+    }
+  }
+  if(victim < 0 || (runq[cpu].total > 0 && most <= runq_load(cpu)))
+    return 0;
+  if((p = runq_draw(&runq[victim], r)) == 0)
+    return 0;
+
+  acquire(&p->lock);
+  if(p->state == RUNNABLE && p->cpu == victim && ((p->affinity >> cpu) & 1) &&
+     (runq[cpu].total == 0 || runq_load(victim) - runq_load(cpu) > p->weight)){
+    runq_update(p, cpu);
+    stolen = 1;
+  }
+  release(&p->lock);
+  return stolen;
+}
+#endif
+// - DEISO - P3
+
+// + DEISO - P3
+// Real-time band: one FIFO of RUNNABLE processes per priority
+// level 1..NRTPRIO, shared by all harts and served before any
+// process with p->rtprio == 0. A real-time process keeps its
+// hart until it sleeps or a higher level shows up; to keep it
+// from starving everyone else, each hart spends at most
+// RTRUNTIME of every RTPERIOD ticks on the band, as measured
+// with r_time() around each run by rt_run().
+// rtq.lock is acquired after p->lock.
+struct {
+  struct spinlock lock;
+  int n;                         // processes queued
+  struct proc *head[NRTPRIO];
+  struct proc *tail[NRTPRIO];
+} rtq;
+
+// Queue p on its level, at the head if it was preempted and
+// should go on before its peers. Caller must hold p->lock.
+static void
+rt_enqueue(struct proc *p, int head)
+{
+  int l = p->rtprio - 1;
+
+  acquire(&rtq.lock);
+  p->rtnext = 0;
+  if(rtq.head[l] == 0){
+    rtq.head[l] = rtq.tail[l] = p;
+  } else if(head){
+    p->rtnext = rtq.head[l];
+    rtq.head[l] = p;
+  } else {
+    rtq.tail[l]->rtnext = p;
+    rtq.tail[l] = p;
+  }
+  rtq.n++;
+  release(&rtq.lock);
+}
+
+// Has this hart used up its real-time share of the period?
+static int
+rt_throttled(struct cpu *c)
+{
+  uint window = r_time() / (RTPERIOD * QUANTUM);
+
+  if(c->rtwindow != window){
+    c->rtwindow = window;
+    c->rtused = 0;
+  }
+  return c->rtused >= RTRUNTIME * QUANTUM;
+}
+
+// Take the first process of the highest non-empty level, and
+// return it locked, or 0 if there is none or the hart is
+// throttled. Once off the queue a RUNNABLE process cannot be
+// reached by anyone else, so it needs no second look.
+static struct proc*
+rt_pick(struct cpu *c)
+{
+  struct proc *p = 0;
+
+  if(rtq.n == 0 || rt_throttled(c))
+    return 0;
+  acquire(&rtq.lock);
+  for(int l = NRTPRIO - 1; l >= 0; l--){
+    if((p = rtq.head[l]) != 0){
+      if((rtq.head[l] = p->rtnext) == 0)
+        rtq.tail[l] = 0;
+      rtq.n--;
+      break;
+    }
+  }
+  release(&rtq.lock);
+  if(p)
+    acquire(&p->lock);
+  return p;
+}
+
+#ifndef RUNQ_SCHED
+static int nready;       // RUNNABLE processes outside the real-time band
+static int nonline;      // harts that have entered scheduler()
+#endif
+
+#ifdef ADAPTIVE
+// Processes waiting for hart cpu, as a hint: read without locks.
+// The round-robin scheduler shares one table among all harts,
+// so each gets an even part of it.
+static int
+nwaiting(int cpu)
+{
+#ifdef RUNQ_SCHED
+  return rtq.n + runq[cpu].n;
+#else
+  return rtq.n + nready / (nonline > 0 ? nonline : 1);
+#endif
+}
+#endif
+
+// Placement. A process keeps its caches and TLB entries warm by
+// running where it ran last. The run-queue schedulers get that
+// by keeping p on runq[p->cpu]; in the round-robin one any hart
+// may take any process, so a hart leaves a process once for the
+// hart it last ran on if that hart is looking for work right
+// now (coldskip()). p->affinity, from setaffinity(), is the set
+// of harts p may run on at all. The real-time band ignores it:
+// every hart serves the one queue.
+
+static uint64 online;    // harts that have entered scheduler(), one bit each
+
+// p is about to run on hart cpu: count it if it moved.
+// Caller must hold p->lock.
+static void
+placed(struct proc *p, int cpu)
+{
+  if(p->lastcpu != cpu){
+    if(p->lastcpu >= 0)
+      p->nmigrate++;
+    p->lastcpu = cpu;
+  }
+  // it starts in the kernel, in sched() or forkret().
+  p->tstamp = r_time();
+  p->inuser = 0;
+  p->changed = p->tstamp;
+}
+
+#ifndef RUNQ_SCHED
+// Should hart cpu leave RUNNABLE p for the hart p last ran on?
+// Only if that hart is in scheduler() and not idle, so it will
+// get to p at once, and only once in a row, so that p cannot be
+// passed over for good. Caller must hold p->lock.
+static int
+coldskip(struct proc *p, int cpu)
+{
+  int last = p->lastcpu;
+
+  if(last < 0 || last == cpu || p->skipped ||
+     cpus[last].proc != 0 || cpus[last].idle){
+    p->skipped = 0;
+    return 0;
+  }
+  p->skipped = 1;
+  return 1;
+}
+#endif
+
+// CPU time. A running process's time is charged in r_time()
+// cycles, to it and to its hart, at every switch and at every
+// trap from and return to user space: the stretch since
+// p->tstamp goes to user time if p was in user space and to
+// system time if not. A hart's time in wfi is its idle time;
+// what is left over it spent in scheduler().
+
+// p, running on this hart, is about to enter user space if
+// touser is set, and to be in the kernel otherwise: charge it
+// for the stretch that ends now. Interrupts must be off.
+void
+cpuacct(struct proc *p, int touser)
+{
+  struct cpu *c = mycpu();
+  uint64 now = r_time();
+  uint64 d = now - p->tstamp;
+
+  if(p->inuser){
+    p->utime += d;
+    c->utime += d;
+  } else {
+    p->stime += d;
+    c->stime += d;
+  }
+  p->tstamp = now;
+  p->inuser = touser;
+}
+
+// The part of the stretch of a RUNNING p that is not charged
+// yet, as of now, or 0. Lock-free, for the statistics.
+static uint64
+unbilled(struct proc *p, uint64 now)
+{
+  uint64 t = p->tstamp;
+
+  if(p->state != RUNNING || now < t)
+    return 0;
+  return now - t;
+}
+
+// Idle harts. A hart with nothing to run waits in wfi with
+// c->idle set, and with make IPI=1 setrunnable() wakes one
+// that may run the new process with an IPI (kick()) instead of
+// leaving it to the hart's next tick or poll. wakegen counts
+// setrunnable()s: a hart that saw it change since it last
+// looked for work looks again rather than sleep, so that a
+// process made RUNNABLE just before the hart set c->idle is
+// not missed.
+
+static uint wakegen;
+
+// p has just become RUNNABLE: get an idle hart that may run it
+// out of wfi. Prefers the hart whose queue p is on, or where it
+// last ran. Caller must hold p->lock.
+static void
+kick(struct proc *p)
+{
+  int self = cpuid();
+#ifdef RUNQ_SCHED
+  int want = p->cpu;
+#else
+  int want = p->lastcpu;
+#endif
+
+  if(want >= 0 && want != self && cpus[want].idle){
+    ipi_send(want);
+    return;
+  }
+  // anyone else who may run it, or, with run queues, steal it.
+  for(int i = 0; i < NCPU; i++){
+    if(i != self && cpus[i].idle && (p->rtprio || ((p->affinity >> i) & 1))){
+      ipi_send(i);
+      return;
+    }
+  }
+}
+
+// Nothing to run on this hart since wakegen was gen: wait for an
+// interrupt. Interrupts stay off from setting c->idle until wfi
+// returns, so that a kick() cannot be taken and lost just
+// before wfi; wfi returns on a pending interrupt all the same.
+static void
+cpuidle(struct cpu *c, uint gen)
+{
+  intr_off();
+#ifdef TICKLESS
+  clockidle();
+#else
+  c->idle = 1;
+#endif
+  __sync_synchronize();
+  c->idlestart = r_time();
+  if(__atomic_load_n(&wakegen, __ATOMIC_SEQ_CST) == gen)
+    asm volatile("wfi");
+  c->idletime += r_time() - c->idlestart;
+  c->idlestart = 0;
+#ifdef TICKLESS
+  clockbusy();
+#else
+  c->idle = 0;
+#endif
+  intr_on();
+}
+
+// The slice p gets when picked to run on cpu, in timer cycles.
+// Real-time processes always get QUANTUM, the unit the band is
+// throttled in. Otherwise it is the one fixed by setquantum(),
+// or SCHEDQUANTUM. Under ADAPTIVE it is p->nextslice, which
+// account() lengthens while p keeps using its whole slice, cut
+// so that every process waiting on the hart gets a turn within
+// MAXQUANTUM. Caller must hold p->lock.
+static uint64
+sliceof(struct proc *p, int cpu)
+{
+  if(p->rtprio)
+    return QUANTUM;
+  if(p->quantum)
+    return p->quantum;
+#ifdef ADAPTIVE
+  uint64 s = MAXQUANTUM / (nwaiting(cpu) + 1);
+
+  if(s > p->nextslice)
+    s = p->nextslice;
+  if(s < MINQUANTUM)
+    s = MINQUANTUM;
+  return s;
+#else
+  return SCHEDQUANTUM;
+#endif
+}
+
+// Record how much of its slice p used before it gave up the
+// CPU. A process that ran out its slice is CPU-bound, and
+// ADAPTIVE doubles its next one, up to MAXQUANTUM; one that
+// blocked goes back to SCHEDQUANTUM.
+// The proportional-share schedulers count a pick as QUANTUM of
+// CPU time, so they settle the difference: a process that
+// blocked early is compensated until it runs again, one that
+// ran for longer is charged for it. Under the lottery it holds
+// tickets/f tickets until its next win, f being the QUANTUMs
+// it used, and under stride scheduling its pass moves by f-1
+// strides.
+// Caller must hold p->lock.
+static void
+account(struct proc *p, uint64 used)
+{
+  if(used > p->slice)
+    used = p->slice;
+  if(used == 0)
+    used = 1;
+  p->used = used * 100 / p->slice;
+  if(used == p->slice){
+    p->nextslice = p->slice * 2;
+    if(p->nextslice > MAXQUANTUM)
+      p->nextslice = MAXQUANTUM;
+  } else if(p->state == SLEEPING){
+    p->nextslice = SCHEDQUANTUM;
+  }
+#ifdef LOTERY_SCHED
+  p->comp = 0;
+  if(p->state == SLEEPING || used > QUANTUM){
+    uint64 t = (uint64)p->tickets * QUANTUM / used;
+    if(t < 1)
+      t = 1;
+    if(t > MAXTICKETS)
+      t = MAXTICKETS;
+    p->comp = (int)t - p->tickets;
+  }
+#endif
+#ifdef STRIDE_SCHED
+  uint64 stride = STRIDE1 / weightof(p);
+  if(p->state == SLEEPING && used < QUANTUM)
+    p->pass -= stride * (QUANTUM - used) / QUANTUM;
+  else if(used > QUANTUM)
+    p->pass += stride * (used - QUANTUM) / QUANTUM;
+#endif
+}
+
+// Run the first process of the real-time band, if the hart
+// may. Returns 1 if it ran one.
+static int
+rt_run(struct cpu *c)
+{
+  struct proc *p;
+  uint64 start, ran;
+
+  if((p = rt_pick(c)) == 0)
+    return 0;
+  p->ticks++;
+  __sync_fetch_and_add(&groups[p->group].ticks, 1);
+  p->state = RUNNING;
+  c->proc = p;
+  placed(p, cpuid());
+  p->slice = sliceof(p, cpuid());
+  clockslice(p->slice);
+  vsswitch(p);
+  start = r_time();
+  swtch(&c->context, &p->context);
+  ran = r_time() - start;
+  // charge the run, however short, to this hart's share.
+  rt_throttled(c);
+  c->rtused += ran;
+  account(p, ran);
+  c->proc = 0;
+  release(&p->lock);
+  return 1;
+}
+// - DEISO - P3
+
+// + DEISO - P3
+// Threads. Every process runs in a vmspace (see proc.h), which
+// clone() shares with the threads it makes. A thread is a child
+// of the thread that made it, reaped by join() rather than
+// wait(). exit() in a thread made by clone() only ends that
+// thread. The process's own thread, the one in trapframe slot 0,
+// ends the whole process: it kills the others and waits for
+// them before it exits, so its parent hears of the exit only
+// once none of them can still use the files. The last thread to
+// exit closes the files and unmaps the memory, and the last one
+// to be reaped frees the page table and the vmspace.
+
+// A fresh vmspace for p, which gets trapframe slot 0.
+static struct vmspace*
+vsalloc(struct proc *p)
+{
+  struct vmspace *vs;
+
+  if((vs = (struct vmspace *)kalloc()) == 0)
+    return 0;
+  memset(vs, 0, sizeof(*vs));
+  initlock(&vs->lock, "vmspace");
+  initsleeplock(&vs->mmlock, "mm");
+  mm_init(&vs->mm);
+  vs->ref = 1;
+  vs->users = 1;
+  vs->tslots = 1;
+  p->tslot = 0;
+  return vs;
+}
+
+// Give p a trapframe slot in vs. Returns -1 if all NTHREAD
+// are taken.
+static int
+vsjoin(struct proc *p, struct vmspace *vs)
+{
+  int slot;
+
+  acquire(&vs->lock);
+  for(slot = 0; slot < NTHREAD; slot++)
+    if((vs->tslots & (1U << slot)) == 0)
+      break;
+  if(slot == NTHREAD){
+    release(&vs->lock);
+    return -1;
+  }
+  vs->tslots |= 1U << slot;
+  vs->ref++;
+  release(&vs->lock);
+  p->tslot = slot;
+  return 0;
+}
+
+// Kill p's other threads and wait for them to exit. clone()
+// makes no new ones once vs->exiting is set.
+static void
+vskill(struct proc *p)
+{
+  struct vmspace *vs = p->vs;
+  struct proc *q;
+  int n;
+
+  acquire(&vs->lock);
+  vs->exiting = 1;
+  n = vs->users - 1;
+  release(&vs->lock);
+  if(n == 0)
+    return;
+
+  for(q = proc; q < &proc[NPROC] && n > 0; q++){
+    if(q == p)
+      continue;
+    acquire(&q->lock);
+    if(q->vs == vs && q->state != ZOMBIE){
+      q->killed = 1;
+      if(q->state == SLEEPING)
+        setrunnable(q);
+      // one spinning in user space must trap to see it.
+      if(q->state == RUNNING)
+        for(int i = 0; i < NCPU; i++)
+          if(cpus[i].proc == q)
+            ipi_send(i);
+      n--;
+    }
+    release(&q->lock);
+  }
+
+  // exit() wakes us under wait_lock once it has counted a
+  // thread out of vs->users.
+  acquire(&wait_lock);
+  while(vs->users > 1)
+    sleep(vs, &wait_lock);
+  release(&wait_lock);
+}
+
+// Let go of p's vmspace. Unmaps p's trapframe from the shared
+// page table, or frees the page table and the vmspace if p was
+// the last to use them.
+static void
+vsput(struct proc *p)
+{
+  struct vmspace *vs = p->vs;
+  int last;
+
+  acquire(&vs->lock);
+  vs->tslots &= ~(1U << p->tslot);
+  last = --vs->ref == 0;
+  release(&vs->lock);
+
+  if(p->pagetable && (!last || p->tslot != 0))
+    uvmunmap(p->pagetable, TRAPFRAMES(p->tslot), 1, 0);
+  if(last){
+    if(p->pagetable)
+      proc_freepagetable(p->pagetable, vs->sz);
+    kfree((void *)vs);
+  }
+  p->pagetable = 0;
+  p->vs = 0;
+  p->mm = 0;
+  p->ofile = 0;
+}
+
+// Lock p's mappings against its other threads. Returns 0 if
+// they could not be locked, because the caller holds spinlocks
+// or holds them already; it then goes ahead without.
+int
+vmlock(struct proc *p)
+{
+  int spin;
+
+  push_off();
+  spin = mycpu()->noff > 1;
+  pop_off();
+  if(spin || holdingsleep(&p->vs->mmlock))
+    return 0;
+  acquiresleep(&p->vs->mmlock);
+  return 1;
+}
+
+void
+vmunlock(struct proc *p)
+{
+  releasesleep(&p->vs->mmlock);
+}
+
+// TLB shootdown. Threads of one vmspace may run on several harts
+// at once, and each hart may cache translations from the shared
+// page table. A thread that takes a page away bumps vs->tlbgen
+// and, before the page may be reused, waits until every other
+// hart running the vmspace has flushed its TLB since. A hart
+// records in c->tlbgen the generation it last flushed at, when
+// it switches to a process and on every return to user space;
+// one spinning in user space is sent an IPI to make it trap, or
+// without make IPI=1 notices at its next tick, which TICKLESS
+// keeps for multithreaded processes (needtick()).
+
+// This hart is about to switch to p's page table, which
+// flushes its TLB. Interrupts must be off.
+void
+tlback(struct proc *p)
+{
+  mycpu()->tlbgen = __atomic_load_n(&p->vs->tlbgen, __ATOMIC_ACQUIRE);
+}
+
+// Is another hart running a thread of vs with a TLB older
+// than gen? If ipi is set, interrupt every such hart.
+static int
+tlbstale(struct vmspace *vs, uint64 gen, int ipi)
+{
+  struct proc *me = myproc();
+  int stale = 0;
+
+  for(struct cpu *c = cpus; c < &cpus[NCPU]; c++){
+    struct proc *q = c->proc;
+    if(q && q != me && q->vs == vs &&
+       __atomic_load_n(&c->tlbgen, __ATOMIC_ACQUIRE) < gen){
+      if(!ipi)
+        return 1;
+      ipi_send(c - cpus);
+      stale = 1;
+    }
+  }
+  return stale;
+}
+
+// Wait until no other hart can use a translation it took from
+// pagetable before the caller changed it. Returns 0, without
+// waiting, if the caller holds spinlocks and so cannot yield;
+// it must then not free what it unmapped.
+int
+tlbshootdown(pagetable_t pagetable)
+{
+  struct proc *p = myproc();
+  struct vmspace *vs;
+  uint64 gen;
+  int spin;
+
+  if(p == 0 || p->pagetable != pagetable)
+    return 1;
+  vs = p->vs;
+  if(vs->users > 1){
+    gen = __atomic_add_fetch(&vs->tlbgen, 1, __ATOMIC_SEQ_CST);
+    if(tlbstale(vs, gen, 0)){
+      push_off();
+      spin = mycpu()->noff > 1;
+      pop_off();
+      if(spin)
+        return 0;
+      if(tlbstale(vs, gen, 1))
+        while(tlbstale(vs, gen, 0))
+          yield();
+    }
+  }
+  return 1;
+}
+
+// Drop a reference to page pa, which the caller has just
+// unmapped from pagetable, once no other hart can reach it.
+// Callers that hold spinlocks do not change the mappings of a
+// process with other threads, so the shootdown cannot fail.
+void
+tlbput(pagetable_t pagetable, void *pa)
+{
+  void *batch = 0;
+
+  if(tlbshootdown(pagetable) == 0)
+    panic("tlbput");
+  kput(&batch, pa);
+  kfreebatch(batch);
+}
+
+// Switch this hart to p's page table.
+static void
+vsswitch(struct proc *p)
+{
+  tlback(p);
+  uvmswitch(p->pagetable);
+}
+// - DEISO - P3
+
 // Allocate a page for each process's kernel stack.
 // Map it high in memory, followed by an invalid
 // guard page.
@@ -66,11 +1200,37 @@ procinit(void)
   
   initlock(&pid_lock, "nextpid");
   initlock(&wait_lock, "wait_lock");
+  // + DEISO - P3
+  initlock(&rtq.lock, "rtq");
+  initlock(&glock, "groups");
+  for(int i = 0; i < NSLEEPQ; i++)
+    initlock(&sleepq[i].lock, "sleepq");
+  initlock(&freelock, "freeprocs");
+  initsleeplock(&pstatlock, "pstat");
+  if(sizeof(struct vmspace) > PGSIZE)
+    panic("procinit: vmspace");
+  for(int i = 0; i < NPIDHASH; i++)
+    initlock(&pidhash[i].lock, "pidhash");
+  // - DEISO - P3
   for(p = proc; p < &proc[NPROC]; p++) {
       initlock(&p->lock, "proc");
       p->state = UNUSED;
       p->kstack = KSTACK((int) (p - proc));
   }
+  // + DEISO - P3
+  for(p = &proc[NPROC - 1]; p >= proc; p--){
+    p->freenext = freeprocs;
+    freeprocs = p;
+  }
+  // - DEISO - P3
+  // + DEISO - P3
+#ifdef RUNQ_SCHED
+  for(int i = 0; i < NCPU; i++){
+    initlock(&runq[i].lock, "runq");
+    runq_init(&runq[i]);
+  }
+#endif
+  // - DEISO - P3
 }
 
 // Must be called with interrupts disabled,
@@ -117,28 +1277,31 @@ allocpid()
   return pid;
 }
 
-// Look in the process table for an UNUSED proc.
+// Take an UNUSED proc off the free list.
 // If found, initialize state required to run in the kernel,
-// and return with p->lock held.
+// and return with p->lock held. It gets a vmspace of its own,
+// or joins share's if share is not 0.
 // If there are no free procs, or a memory allocation fails, return 0.
 static struct proc*
-allocproc(void)
+allocproc(struct proc *share)
 {
   struct proc *p;
 
-  for(p = proc; p < &proc[NPROC]; p++) {
-    acquire(&p->lock);
-    if(p->state == UNUSED) {
-      goto found;
-    } else {
-      release(&p->lock);
-    }
-  }
-  return 0;
+  // + DEISO - P3
+  acquire(&freelock);
+  if((p = freeprocs) != 0)
+    freeprocs = p->freenext;
+  release(&freelock);
+  if(p == 0)
+    return 0;
+  acquire(&p->lock);
+  // - DEISO - P3
 
-found:
   p->pid = allocpid();
   p->state = USED;
+  // + DEISO - P3
+  pidhash_insert(p);
+  // - DEISO - P3
 
   // Allocate a trapframe page.
   if((p->trapframe = (struct trapframe *)kalloc()) == 0){
@@ -147,7 +1310,29 @@ found:
     return 0;
   }
 
+  // + DEISO - P3
+  if(share == 0){
+    p->vs = vsalloc(p);
+  } else if(vsjoin(p, share->vs) == 0){
+    p->vs = share->vs;
+  }
+  if(p->vs == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+  p->mm = &p->vs->mm;
+  p->ofile = p->vs->ofile;
+
+  // - DEISO - P3
+
   // An empty user page table.
+  // + DEISO - P3
+  // Or, for a thread, share's.
+  if(share)
+    p->pagetable = proc_sharepagetable(p, share->pagetable);
+  else
+  // - DEISO - P3
   p->pagetable = proc_pagetable(p);
   if(p->pagetable == 0){
     freeproc(p);
@@ -166,9 +1351,27 @@ found:
   p->ticks = 0;
   // - DEISO - P1
 
-  // + DEISO - P2
-  mm_init(&p->mm);
-  // - DEISO - P2
+  // + DEISO - P3
+  p->stacklimit = USERSTACKLIMIT;
+  memset(&p->mstat, 0, sizeof(p->mstat));
+  p->pass = 0;
+  p->rtprio = 0;
+  p->group = 0;
+  p->used = 0;
+  p->comp = 0;
+  p->quantum = 0;
+  p->slice = QUANTUM;
+  p->nextslice = SCHEDQUANTUM;
+  p->nvcsw = 0;
+  p->nivcsw = 0;
+  p->affinity = ~0UL;
+  p->lastcpu = -1;
+  p->nmigrate = 0;
+  p->skipped = 0;
+  p->utime = 0;
+  p->stime = 0;
+  p->changed = r_time();
+  // - DEISO - P3
 
   return p;
 }
@@ -188,10 +1391,16 @@ freeproc(struct proc *p)
   if(p->trapframe)
     kfree((void*)p->trapframe);
   p->trapframe = 0;
-  if(p->pagetable)
-    proc_freepagetable(p->pagetable, p->sz);
+  // + DEISO - P3
+  // The page table goes with the vmspace.
+  if(p->vs)
+    vsput(p);
+  // - DEISO - P3
   p->pagetable = 0;
-  p->sz = 0;
+  // + DEISO - P3
+  if(p->pid)
+    pidhash_remove(p);
+  // - DEISO - P3
   p->pid = 0;
   p->parent = 0;
   p->name[0] = 0;
@@ -199,6 +1408,13 @@ freeproc(struct proc *p)
   p->killed = 0;
   p->xstate = 0;
   p->state = UNUSED;
+  // + DEISO - P3
+  p->changed = r_time();
+  acquire(&freelock);
+  p->freenext = freeprocs;
+  freeprocs = p;
+  release(&freelock);
+  // - DEISO - P3
 }
 
 // Create a user page table for a given process, with no user memory,
@@ -235,6 +1451,20 @@ proc_pagetable(struct proc *p)
   return pagetable;
 }
 
+// + DEISO - P3
+// Map a thread's trapframe into the page table it shares, in
+// the thread's slot. The slots share a page-table page with the
+// trampoline, so this allocates nothing and needs no mmlock.
+pagetable_t
+proc_sharepagetable(struct proc *p, pagetable_t pagetable)
+{
+  if(mappages(pagetable, TRAPFRAMES(p->tslot), PGSIZE,
+              (uint64)(p->trapframe), PTE_R | PTE_W) < 0)
+    return 0;
+  return pagetable;
+}
+// - DEISO - P3
+
 // Free a process's page table, and free the
 // physical memory it refers to.
 void
@@ -264,13 +1494,15 @@ userinit(void)
 {
   struct proc *p;
 
-  p = allocproc();
+  p = allocproc(0);
   initproc = p;
   
   // allocate one user page and copy initcode's instructions
   // and data into it.
   uvmfirst(p->pagetable, initcode, sizeof(initcode));
-  p->sz = PGSIZE;
+  // + DEISO - P3
+  p->vs->sz = PGSIZE;
+  // - DEISO - P3
 
   // prepare for the very first "return" from kernel to user.
   p->trapframe->epc = 0;      // user program counter
@@ -279,7 +1511,12 @@ userinit(void)
   safestrcpy(p->name, "initcode", sizeof(p->name));
   p->cwd = namei("/");
 
-  p->state = RUNNABLE;
+  // + DEISO - P3
+  acquire(&glock);
+  group_move(p, -1, 0);
+  release(&glock);
+  setrunnable(p);
+  // - DEISO - P3
 
   release(&p->lock);
 }
@@ -291,16 +1528,27 @@ growproc(int n)
 {
   uint64 sz;
   struct proc *p = myproc();
+  // + DEISO - P3
+  int locked = vmlock(p);
 
-  sz = p->sz;
+  sz = p->vs->sz;
+  // - DEISO - P3
   if(n > 0){
     if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
+      // + DEISO - P3
+      if(locked)
+        vmunlock(p);
+      // - DEISO - P3
       return -1;
     }
   } else if(n < 0){
     sz = uvmdealloc(p->pagetable, sz, sz + n);
   }
-  p->sz = sz;
+  // + DEISO - P3
+  p->vs->sz = sz;
+  if(locked)
+    vmunlock(p);
+  // - DEISO - P3
   return 0;
 }
 
@@ -309,22 +1557,39 @@ growproc(int n)
 int
 fork(void)
 {
-  int i, pid;
+  int i;
   struct proc *np;
   struct proc *p = myproc();
+  // + DEISO - P3
+  // Keep our other threads from changing the mappings while
+  // they are copied.
+  int locked = vmlock(p);
+  // - DEISO - P3
 
   // Allocate process.
-  if((np = allocproc()) == 0){
+  if((np = allocproc(0)) == 0){
+    // + DEISO - P3
+    if(locked)
+      vmunlock(p);
+    // - DEISO - P3
     return -1;
   }
 
   // Copy user memory from parent to child.
-  if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
+  // + DEISO - P3
+  if(uvmcopy(p->pagetable, np->pagetable, p->vs->sz) < 0){
+  // - DEISO - P3
     freeproc(np);
     release(&np->lock);
+    // + DEISO - P3
+    if(locked)
+      vmunlock(p);
+    // - DEISO - P3
     return -1;
   }
-  np->sz = p->sz;
+  // + DEISO - P3
+  np->vs->sz = p->vs->sz;
+  // - DEISO - P3
 
   // copy saved user registers.
   *(np->trapframe) = *(p->trapframe);
@@ -333,34 +1598,112 @@ fork(void)
   np->trapframe->a0 = 0;
 
   // + DEISO - P2
-  mm_copy(&p->mm, &np->mm);
+  mm_copy(p->mm, np->mm);
   // - DEISO - P2
 
+  // + DEISO - P3
+  // uvmcopy() made our writable pages copy-on-write. Our other
+  // threads must stop writing to them through their TLBs
+  // before the child gets to see them.
+  release(&np->lock);
+  tlbshootdown(p->pagetable);
+  if(locked)
+    vmunlock(p);
+  acquire(&np->lock);
+  // - DEISO - P3
+
   // increment reference counts on open file descriptors.
+  // + DEISO - P3
+  acquire(&p->vs->lock);
+  // - DEISO - P3
   for(i = 0; i < NOFILE; i++)
     if(p->ofile[i])
       np->ofile[i] = filedup(p->ofile[i]);
+  // + DEISO - P3
+  release(&p->vs->lock);
+  // - DEISO - P3
+  np->cwd = idup(p->cwd);
+
+  // + DEISO - P3
+  return procstart(p, np);
+  // - DEISO - P3
+}
+
+// + DEISO - P3
+// Create a thread that runs fn(arg) on the stack that ends at
+// stack, in the caller's vmspace. It is the caller's child, and
+// returns to user space like a new process, in fn.
+int
+clone(uint64 fn, uint64 arg, uint64 stack)
+{
+  struct proc *np;
+  struct proc *p = myproc();
+
+  if((np = allocproc(p)) == 0)
+    return -1;
+
+  // the caller's registers, but a new pc, argument and stack.
+  // fn must not return; ra 0 makes sure it faults if it does.
+  *(np->trapframe) = *(p->trapframe);
+  np->trapframe->epc = fn;
+  np->trapframe->a0 = arg;
+  np->trapframe->sp = stack;
+  np->trapframe->ra = 0;
+
+  acquire(&p->vs->lock);
+  if(p->vs->exiting){
+    release(&p->vs->lock);
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+  p->vs->users++;
+  release(&p->vs->lock);
+
   np->cwd = idup(p->cwd);
 
+  return procstart(p, np);
+}
+
+// Give np, freshly made by p with np->lock held, what it
+// inherits from p, and set it running. Returns its pid.
+static int
+procstart(struct proc *p, struct proc *np)
+{
+  int pid;
+
   safestrcpy(np->name, p->name, sizeof(p->name));
 
+  np->stacklimit = p->stacklimit;
+  np->rtprio = p->rtprio;
+  np->quantum = p->quantum;
+  np->affinity = p->affinity;
+  acquire(&glock);
+  group_move(np, -1, p->group);
+  release(&glock);
+
   pid = np->pid;
 
   release(&np->lock);
 
   acquire(&wait_lock);
   np->parent = p;
+  kin_push(&p->children, np);
   // + DEISO - P1
   np->tickets = p->tickets;
   // - DEISO - P1
   release(&wait_lock);
 
   acquire(&np->lock);
-  np->state = RUNNABLE;
+#ifdef RUNQ_SCHED
+  np->cpu = runq_idlest(p->cpu, np->affinity);
+#endif
+  setrunnable(np);
   release(&np->lock);
 
   return pid;
 }
+// - DEISO - P3
 
 // Pass p's abandoned children to init.
 // Caller must hold wait_lock.
@@ -369,12 +1712,21 @@ reparent(struct proc *p)
 {
   struct proc *pp;
 
-  for(pp = proc; pp < &proc[NPROC]; pp++){
-    if(pp->parent == p){
+  // + DEISO - P3
+  while((pp = p->children) != 0){
+    kin_unlink(pp);
+    pp->parent = initproc;
+    kin_push(&initproc->children, pp);
+  }
+  if(p->zombies){
+    while((pp = p->zombies) != 0){
+      kin_unlink(pp);
       pp->parent = initproc;
-      wakeup(initproc);
+      kin_push(&initproc->zombies, pp);
     }
+    wakeup(initproc);
   }
+  // - DEISO - P3
 }
 
 // Exit the current process.  Does not return.
@@ -388,6 +1740,17 @@ exit(int status)
   if(p == initproc)
     panic("init exiting");
 
+  // + DEISO - P3
+  if(p->tslot == 0)
+    vskill(p);
+
+  // Only the last thread takes down what they all share.
+  int last;
+  acquire(&p->vs->lock);
+  last = --p->vs->users == 0;
+  release(&p->vs->lock);
+  if(last){
+  // - DEISO - P3
   // Close all open files.
   for(int fd = 0; fd < NOFILE; fd++){
     if(p->ofile[fd]){
@@ -398,8 +1761,11 @@ exit(int status)
   }
 
   // + DEISO - P2
-  mm_destroy(&p->mm, p->pagetable);
+  mm_destroy(p->mm, p->pagetable);
   // - DEISO - P2
+  // + DEISO - P3
+  }
+  // - DEISO - P3
 
   begin_op();
   iput(p->cwd);
@@ -411,12 +1777,27 @@ exit(int status)
   // Give any children to init.
   reparent(p);
 
+  // + DEISO - P3
+  kin_unlink(p);
+  kin_push(&p->parent->zombies, p);
+  // - DEISO - P3
+
   // Parent might be sleeping in wait().
   wakeup(p->parent);
+  // + DEISO - P3
+  // The process's own thread might be waiting in vskill().
+  if(p->tslot != 0)
+    wakeup(p->vs);
+  // - DEISO - P3
   
   acquire(&p->lock);
 
   p->xstate = status;
+  // + DEISO - P3
+  acquire(&glock);
+  group_move(p, p->group, -1);
+  release(&glock);
+  // - DEISO - P3
   p->state = ZOMBIE;
 
   release(&wait_lock);
@@ -426,56 +1807,95 @@ exit(int status)
   panic("zombie exit");
 }
 
-// Wait for a child process to exit and return its pid.
-// Return -1 if this process has no children.
-int
-wait(uint64 addr)
+// + DEISO - P3
+// Is pp one of the children p waits for? Threads, those in p's
+// vmspace, are left to join(); tid, if above 0, picks one.
+static int
+iskid(struct proc *p, struct proc *pp, int thread, int tid)
+{
+  if((pp->vs == p->vs) != thread)
+    return 0;
+  return tid <= 0 || pp->pid == tid;
+}
+
+// Wait for a child process, or with thread set for a thread,
+// to exit, and return its pid.
+// Return -1 if this process has no such children.
+static int
+reap(uint64 addr, int thread, int tid)
 {
   struct proc *pp;
-  int havekids, pid;
+  int pid;
   struct proc *p = myproc();
 
   acquire(&wait_lock);
 
   for(;;){
-    // Scan through table looking for exited children.
-    havekids = 0;
-    for(pp = proc; pp < &proc[NPROC]; pp++){
-      if(pp->parent == p){
-        // make sure the child isn't still in exit() or swtch().
-        acquire(&pp->lock);
-
-        havekids = 1;
-        if(pp->state == ZOMBIE){
-          // Found one.
-          pid = pp->pid;
-          if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
-                                  sizeof(pp->xstate)) < 0) {
-            release(&pp->lock);
-            release(&wait_lock);
-            return -1;
-          }
-          freeproc(pp);
-          release(&pp->lock);
-          release(&wait_lock);
-          return pid;
-        }
+    // Take the first exited child of the right kind, if any.
+    for(pp = p->zombies; pp; pp = pp->sibling)
+      if(iskid(p, pp, thread, tid))
+        break;
+    if(pp != 0){
+      // make sure the child isn't still in exit() or swtch().
+      acquire(&pp->lock);
+
+      pid = pp->pid;
+      if(addr != 0 && copyout(p->pagetable, addr, (char *)&pp->xstate,
+                              sizeof(pp->xstate)) < 0) {
         release(&pp->lock);
+        release(&wait_lock);
+        // + DEISO - P3
+        // Another thread of ours may have the page; fault it in
+        // without the locks and start over. See uvmaccess().
+        if(uvmprefault(p->pagetable, addr, sizeof(pp->xstate), 1) < 0)
+          return -1;
+        acquire(&wait_lock);
+        continue;
+        // - DEISO - P3
       }
+      kin_unlink(pp);
+      freeproc(pp);
+      release(&pp->lock);
+      release(&wait_lock);
+      return pid;
     }
 
     // No point waiting if we don't have any children.
-    if(!havekids || killed(p)){
+    for(pp = p->children; pp; pp = pp->sibling)
+      if(iskid(p, pp, thread, tid))
+        break;
+    if(pp == 0 || killed(p)){
       release(&wait_lock);
       return -1;
     }
-    
+
     // Wait for a child to exit.
     sleep(p, &wait_lock);  //DOC: wait-sleep
   }
 }
+// - DEISO - P3
 
-#ifdef LOTERY_SCHED
+// Wait for a child process to exit and return its pid.
+// Return -1 if this process has no children.
+int
+wait(uint64 addr)
+{
+  // + DEISO - P3
+  return reap(addr, 0, 0);
+  // - DEISO - P3
+}
+
+// + DEISO - P3
+// Wait for thread tid, or any if tid is -1, to exit and
+// return its pid. Return -1 if there is no such thread.
+int
+join(int tid)
+{
+  return reap(0, 1, tid);
+}
+// - DEISO - P3
+
+#ifdef RUNQ_SCHED
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
 // Scheduler never returns.  It loops, doing:
@@ -490,7 +1910,17 @@ scheduler(void)
   struct cpu *c = mycpu();
 
   c->proc = 0;
-  int rand_seed = SEMILLA;
+  // + DEISO - P3
+  int id = cpuid();
+  struct runq *rq = &runq[id];
+  // mix the hart id into the boot time so that no two harts
+  // share a stream; xorshift must not start from 0.
+  uint64 rand_seed = r_time() ^ ((id + 1) * 0x9E3779B97F4A7C15UL);
+  if(rand_seed == 0)
+    rand_seed = 1;
+  rq->online = 1;
+  __sync_fetch_and_or(&online, 1UL << id);
+  // - DEISO - P3
   for(;;){
     // The most recent process to run may have had interrupts
     // turned off; enable them to avoid a deadlock if all
@@ -500,56 +1930,53 @@ scheduler(void)
     int found = 0;
 
     // + DEISO - P1
-    int total_tickets = 0;
-    for (p = proc; p < &proc[NPROC]; p++){
-      acquire(&p->lock);
-      if (p->state == RUNNABLE){
-        total_tickets += p->tickets;
-      }
-      release(&p->lock);
-    }
-    rand_seed = (rand_seed * MULTIPLICADOR + INCREMENTO) % MODULO;
-    int winning_ticket = rand_seed % total_tickets;
-	if (winning_ticket < 0) {
-		winning_ticket = winning_ticket * -1;
-	}
-	int suma_tickets = 0;
-	int winner_found = 0;
-	struct proc *winner;
-	p = proc;
-    while((p < &proc[NPROC]) && (winner_found == 0)){
-      acquire(&p->lock);
-      if(p->state == RUNNABLE) {
-        suma_tickets += p->tickets;
-        // Se encuentra el proceso ganador
-        if(suma_tickets > winning_ticket){
-          winner = p;
-          winner_found = 1;
-        }
-      }
-      release(&p->lock);
-      p++;
-    }
-    if(winner_found == 1){
-      acquire(&winner->lock);
+    // + DEISO - P3
+    uint gen = wakegen;
+    if(rt_run(c))
+      continue;
 
-      winner->ticks++;
+    // Even out the queues, then pick a process off our own
+    // queue and lock it. Another hart may have stolen it in
+    // between, so check it is still ours and pick again if not.
+    runq_steal(id, lottery_rand(&rand_seed));
+    p = runq_draw(rq, lottery_rand(&rand_seed));
+    if(p != 0){
+      acquire(&p->lock);
+      if(p->state == RUNNABLE && p->cpu == id){
+        p->ticks++;
 
-      winner->state = RUNNING;
-      c->proc = winner;
-      swtch(&c->context, &winner->context);
+        p->state = RUNNING;
+        runq_update(p, id);
+#ifdef STRIDE_SCHED
+        rq->vtime = p->pass;
+        p->pass += STRIDE1 / weightof(p);
+#endif
+        rq->running = weightof(p);
+        __sync_fetch_and_add(&groups[p->group].ticks, 1);
+        c->proc = p;
+        placed(p, id);
+        p->slice = sliceof(p, id);
+        clockslice(p->slice);
+        vsswitch(p);
+        uint64 start = r_time();
+        swtch(&c->context, &p->context);
+        account(p, r_time() - start);
+        runq_requeue(p);
 
-      c->proc = 0;
+        c->proc = 0;
+        rq->running = 0;
+      }
+      release(&p->lock);
       found = 1;
-
-      release(&winner->lock);
     }
+    // - DEISO - P3
     // - DEISO - P1
 
     if(found == 0) {
       // nothing to run; stop running on this core until an interrupt.
-      intr_on();
-      asm volatile("wfi");
+      // + DEISO - P3
+      cpuidle(c, gen);
+      // - DEISO - P3
     }
   }
 }
@@ -562,6 +1989,11 @@ scheduler(void)
   struct cpu *c = mycpu();
 
   c->proc = 0;
+  // + DEISO - P3
+  int id = cpuid();
+  __sync_fetch_and_add(&nonline, 1);
+  __sync_fetch_and_or(&online, 1UL << id);
+  // - DEISO - P3
   for(;;){
     // The most recent process to run may have had interrupts
     // turned off; enable them to avoid a deadlock if all
@@ -569,15 +2001,41 @@ scheduler(void)
     intr_on();
 
     int found = 0;
+    // + DEISO - P3
+    uint gen = wakegen;
+    if(rt_run(c))
+      continue;
+    // - DEISO - P3
     for(p = proc; p < &proc[NPROC]; p++) {
       acquire(&p->lock);
-      if(p->state == RUNNABLE) {
+      // + DEISO - P3
+      // real-time processes are run by rt_run().
+      if(p->state == RUNNABLE && p->rtprio == 0 &&
+         ((p->affinity >> id) & 1)) {
+        if(coldskip(p, id)){
+          // come back for it if there is nothing else.
+          release(&p->lock);
+          found = 1;
+          continue;
+        }
+      // - DEISO - P3
         // Switch to chosen process.  It is the process's job
         // to release its lock and then reacquire it
         // before jumping back to us.
         p->state = RUNNING;
         c->proc = p;
+        // + DEISO - P3
+        __sync_fetch_and_sub(&nready, 1);
+        placed(p, id);
+        p->slice = sliceof(p, id);
+        clockslice(p->slice);
+        vsswitch(p);
+        uint64 start = r_time();
+        // - DEISO - P3
         swtch(&c->context, &p->context);
+        // + DEISO - P3
+        account(p, r_time() - start);
+        // - DEISO - P3
 
         // Process is done running for now.
         // It should have changed its p->state before coming back.
@@ -585,11 +2043,19 @@ scheduler(void)
         found = 1;
       }
       release(&p->lock);
+      // + DEISO - P3
+      // start over if the real-time band has work for us.
+      if(rtq.n > 0 && !rt_throttled(c)){
+        found = 1;
+        break;
+      }
+      // - DEISO - P3
     }
     if(found == 0) {
       // nothing to run; stop running on this core until an interrupt.
-      intr_on();
-      asm volatile("wfi");
+      // + DEISO - P3
+      cpuidle(c, gen);
+      // - DEISO - P3
     }
   }
 }
@@ -617,18 +2083,69 @@ sched(void)
   if(intr_get())
     panic("sched interruptible");
 
+  // + DEISO - P3
+  if(p->state == RUNNABLE)
+    p->nivcsw++;
+  else
+    p->nvcsw++;
+  cpuacct(p, 0);
+  p->changed = p->tstamp;
+  // - DEISO - P3
   intena = mycpu()->intena;
   swtch(&p->context, &mycpu()->context);
   mycpu()->intena = intena;
 }
 
+// + DEISO - P3
+// Make p RUNNABLE and let the scheduler see it.
+// Caller must hold p->lock.
+static void
+setrunnable(struct proc *p)
+{
+  if(p->state != RUNNING)
+    group_active(p, p->tickets);
+  p->state = RUNNABLE;
+  p->changed = r_time();
+#ifdef TICKLESS
+#if defined(RUNQ_SCHED) && !defined(IPI)
+  // with no IPI to wake it, an idle hart would not see p until
+  // it next polls, so give p to this hart instead.
+  if(cpus[p->cpu].idle && ((p->affinity >> cpuid()) & 1))
+    p->cpu = cpuid();
+#endif
+  // this hart must tick now to get p a turn.
+  clockarm();
+#endif
+  if(p->rtprio){
+    rt_enqueue(p, 0);
+  } else {
+#ifdef RUNQ_SCHED
+    runq_update(p, p->cpu);
+#else
+    __sync_fetch_and_add(&nready, 1);
+#endif
+  }
+  __sync_fetch_and_add(&wakegen, 1);
+  kick(p);
+}
+// - DEISO - P3
+
 // Give up the CPU for one scheduling round.
 void
 yield(void)
 {
   struct proc *p = myproc();
   acquire(&p->lock);
-  p->state = RUNNABLE;
+  // + DEISO - P3
+  if(p->rtprio){
+    // let p go on first among its peers; rt_run() charges
+    // the time it ran.
+    p->state = RUNNABLE;
+    rt_enqueue(p, 1);
+  } else {
+    setrunnable(p);
+  }
+  // - DEISO - P3
   sched();
   release(&p->lock);
 }
@@ -663,28 +2180,29 @@ void
 sleep(void *chan, struct spinlock *lk)
 {
   struct proc *p = myproc();
+  // + DEISO - P3
+  struct sleepq *q = sleepq_of(chan);
+  // - DEISO - P3
   
   // Must acquire p->lock in order to
   // change p->state and then call sched.
-  // Once we hold p->lock, we can be
+  // + DEISO - P3
+  // Once we hold q->lock, we can be
   // guaranteed that we won't miss any wakeup
-  // (wakeup locks p->lock),
+  // (wakeup locks q->lock),
   // so it's okay to release lk.
 
+  acquire(&q->lock);
+  // - DEISO - P3
   acquire(&p->lock);  //DOC: sleeplock1
   release(lk);
 
   // Go to sleep.
-  p->chan = chan;
-  p->state = SLEEPING;
-
-  sched();
-
-  // Tidy up.
-  p->chan = 0;
+  // + DEISO - P3
+  sleepq_sleep(q, p, chan);
+  // - DEISO - P3
 
   // Reacquire original lock.
-  release(&p->lock);
   acquire(lk);
 }
 
@@ -693,18 +2211,62 @@ sleep(void *chan, struct spinlock *lk)
 void
 wakeup(void *chan)
 {
-  struct proc *p;
+  // + DEISO - P3
+  sleepq_wake(chan, -1);
+  // - DEISO - P3
+}
 
-  for(p = proc; p < &proc[NPROC]; p++) {
-    if(p != myproc()){
-      acquire(&p->lock);
-      if(p->state == SLEEPING && p->chan == chan) {
-        p->state = RUNNABLE;
-      }
-      release(&p->lock);
-    }
+// + DEISO - P3
+// Futexes. Sleepers on a user word wait on a channel from
+// futexchan(). The word is checked under the sleep queue's lock,
+// which futexwake() takes too, so a wake that follows a change of
+// the word cannot be missed.
+
+// The channel for the user word at va, backed by pa. Processes
+// sharing a MAP_SHARED page meet on its physical address. Any
+// other page is private to the vmspace, and copy-on-write after
+// a fork() can move it to a new physical page between a wait and
+// a wake, so threads meet on (vmspace, va) instead: va's bits,
+// above them the vmspace's page number, and the top bit set so
+// that it equals no kernel or physical address.
+void*
+futexchan(uint64 va, uint64 pa, int shared)
+{
+  uint64 vs = (uint64)myproc()->vs / PGSIZE;
+
+  if(shared)
+    return (void *)pa;
+  return (void *)((1L << 63) | vs * MAXVA | va);
+}
+
+// Sleep on chan if the word at va is still val. The word is read
+// through the current mapping, so a copy made by a concurrent
+// copy-on-write fault is seen. Returns -1 at once if it is not
+// val, or if the caller has been killed.
+int
+futexwait(void *chan, uint64 va, int val)
+{
+  struct proc *p = myproc();
+  struct sleepq *q = sleepq_of(chan);
+  int cur;
+
+  acquire(&q->lock);
+  if(uvmload(p->pagetable, va, &cur) < 0 || cur != val || killed(p)){
+    release(&q->lock);
+    return -1;
   }
+  acquire(&p->lock);
+  sleepq_sleep(q, p, chan);
+  return 0;
+}
+
+// Wake up to n processes sleeping on chan; returns how many.
+int
+futexwake(void *chan, int n)
+{
+  return sleepq_wake(chan, n);
 }
+// - DEISO - P3
 
 // Kill the process with the given pid.
 // The victim won't exit until it tries to return
@@ -714,20 +2276,17 @@ kill(int pid)
 {
   struct proc *p;
 
-  for(p = proc; p < &proc[NPROC]; p++){
-    acquire(&p->lock);
-    if(p->pid == pid){
-      p->killed = 1;
-      if(p->state == SLEEPING){
-        // Wake process from sleep().
-        p->state = RUNNABLE;
-      }
-      release(&p->lock);
-      return 0;
-    }
-    release(&p->lock);
+  // + DEISO - P3
+  if((p = findproc(pid)) == 0)
+    return -1;
+  p->killed = 1;
+  if(p->state == SLEEPING){
+    // Wake process from sleep().
+    setrunnable(p);
   }
-  return -1;
+  release(&p->lock);
+  return 0;
+  // - DEISO - P3
 }
 
 void
@@ -783,17 +2342,298 @@ either_copyin(void *dst, int user_src, uint64 src, uint64 len)
 int
 getpinfo(struct pstat *addr) 
 {
+  // + DEISO - P3
+  uint64 now;
+  // - DEISO - P3
+
   for(int i = 0; i < NPROC; i++){
     addr->inuse[i] = (proc[i].state != UNUSED);
     addr->pid[i] = proc[i].pid;
     addr->tickets[i] = proc[i].tickets;
     addr->ticks[i] = proc[i].ticks;
+    // + DEISO - P3
+    addr->used[i] = proc[i].used;
+    addr->nvcsw[i] = proc[i].nvcsw;
+    addr->nivcsw[i] = proc[i].nivcsw;
+    addr->cpu[i] = proc[i].lastcpu;
+    addr->nmigrate[i] = proc[i].nmigrate;
+    addr->affinity[i] = proc[i].affinity;
+    addr->utime[i] = proc[i].utime;
+    addr->stime[i] = proc[i].stime;
+    // bill the stretch a running process is in to what it
+    // is doing now.
+    now = r_time();
+    if(proc[i].inuser)
+      addr->utime[i] += unbilled(&proc[i], now);
+    else
+      addr->stime[i] += unbilled(&proc[i], now);
+    safestrcpy(addr->name[i], proc[i].name, sizeof(addr->name[i]));
+    // - DEISO - P3
   } 
 
   return 0;
 }
 // - DEISO - P1
 
+// + DEISO - P3
+// Fill in the memory counters of process pid, or of the
+// calling process if pid is 0. Returns -1 if there is no
+// such process.
+int
+getmstat(int pid, struct mstat *st)
+{
+  struct proc *p;
+
+  if(pid == 0)
+    pid = myproc()->pid;
+
+  if((p = findproc(pid)) == 0)
+    return -1;
+  *st = p->mstat;
+  st->pid = pid;
+  st->rss = 0;
+  st->shared = 0;
+  // Holding p->lock keeps the page-table pages from being
+  // freed under us by exec() or wait().
+  if(p->pagetable)
+    uvmcount(p->pagetable, 2, &st->rss, &st->shared);
+  release(&p->lock);
+  return 0;
+}
+// - DEISO - P3
+
+// + DEISO - P3
+#ifdef TICKLESS
+// Does this hart need its tick? Only to preempt the running
+// process: for a process waiting on this hart's run queue or
+// in the real-time band, to throttle a real-time process, or,
+// without IPIs, for a thread to see TLB shootdowns. The
+// round-robin scheduler cannot tell, so it always ticks while
+// busy. Interrupts must be off.
+int
+needtick(void)
+{
+  struct cpu *c = mycpu();
+
+  if(c->proc == 0)
+    return 0;
+  if(rtq.n > 0 || c->proc->rtprio)
+    return 1;
+#ifndef IPI
+  // TLB shootdowns wait for the other threads' harts to trap.
+  if(c->proc->vs->users > 1)
+    return 1;
+#endif
+#ifdef RUNQ_SCHED
+  return runq[cpuid()].total > 0;
+#else
+  return 1;
+#endif
+}
+#endif
+
+// + DEISO - P3
+// Let process pid, or the caller if pid is 0, run only on the
+// harts in mask. Returns -1 if there is no such process or mask
+// holds no hart that is running.
+int
+setaffinity(int pid, uint64 mask)
+{
+  struct proc *p, *me = myproc();
+  int move;
+
+  mask &= online;
+  if(mask == 0)
+    return -1;
+  if(pid == 0){
+    p = me;
+    acquire(&p->lock);
+  } else if((p = findproc(pid)) == 0){
+    return -1;
+  }
+  p->affinity = mask;
+#ifdef RUNQ_SCHED
+  // take p off a queue it may no longer be on.
+  if(((mask >> p->cpu) & 1) == 0)
+    runq_update(p, runq_idlest(p->cpu, mask));
+#endif
+  push_off();
+  move = p == me && ((mask >> cpuid()) & 1) == 0;
+  pop_off();
+  release(&p->lock);
+  // get off this hart.
+  if(move)
+    yield();
+  return 0;
+}
+// - DEISO - P3
+
+// Set the caller's tickets, keeping its group's count of
+// active tickets in step.
+void
+settickets(int tickets)
+{
+  struct proc *p = myproc();
+
+  acquire(&p->lock);
+  group_active(p, tickets - p->tickets);
+  p->tickets = tickets;
+  p->changed = r_time();
+  release(&p->lock);
+}
+
+// Set the caller's real-time level, 0 to leave the band. The
+// scheduler reads it under p->lock. It takes effect the next
+// time the caller is queued.
+void
+setrtprio(int prio)
+{
+  struct proc *p = myproc();
+
+  acquire(&p->lock);
+  p->rtprio = prio;
+  release(&p->lock);
+}
+
+// Make a new group funded with tickets base tickets and move
+// the caller into it; its children will follow it there.
+// Returns the group id, or -1 if all groups are taken.
+int
+mkgroup(int tickets)
+{
+  struct proc *p = myproc();
+  int g;
+
+  acquire(&p->lock);
+  acquire(&glock);
+  for(g = 1; g < NGROUP; g++)
+    if(groups[g].members == 0)
+      break;
+  if(g == NGROUP){
+    release(&glock);
+    release(&p->lock);
+    return -1;
+  }
+  groups[g].tickets = tickets;
+  groups[g].active = 0;
+  groups[g].ticks = 0;
+  group_move(p, p->group, g);
+  release(&glock);
+  release(&p->lock);
+  return g;
+}
+
+// Report the usage of group gid. Returns -1 if there is no
+// such group.
+int
+getgstat(int gid, struct gstat *st)
+{
+  struct group *g;
+
+  if(gid < 0 || gid >= NGROUP)
+    return -1;
+  g = &groups[gid];
+  acquire(&glock);
+  if(gid != 0 && g->members == 0){
+    release(&glock);
+    return -1;
+  }
+  st->gid = gid;
+  st->tickets = g->tickets;
+  st->members = g->members;
+  st->active = g->active;
+  st->ticks = g->ticks;
+  release(&glock);
+  return 0;
+}
+
+// Report how every hart spent its time, billing what each is
+// doing now up to now. Lock-free, so a little stale.
+void
+getcpustat(struct cpustat *st)
+{
+  uint64 now = r_time();
+
+  st->now = now;
+  for(int i = 0; i < NCPU; i++){
+    struct cpu *c = &cpus[i];
+    struct proc *p = c->proc;
+    uint64 t = c->idlestart;
+
+    st->cpu[i].online = (online >> i) & 1;
+    st->cpu[i].ticks = c->ticks;
+    st->cpu[i].utime = c->utime;
+    st->cpu[i].stime = c->stime;
+    st->cpu[i].idle = c->idletime;
+    if(t && t < now)
+      st->cpu[i].idle += now - t;
+    if(p){
+      if(p->inuser)
+        st->cpu[i].utime += unbilled(p, now);
+      else
+        st->cpu[i].stime += unbilled(p, now);
+    }
+  }
+}
+
+// Copy out to the user array buf up to n slots of the process
+// table, from q->slot on, that changed after q->since, or all
+// slots in use if q->since is 0. A RUNNING process is always
+// reported, since its times move without a change being
+// recorded. Unchanged slots are passed over without a lock,
+// so a poll of a quiet table is cheap. Returns the number of
+// slots copied out, or -1.
+int
+procstat(struct procquery *q, uint64 buf, int n)
+{
+  struct procinfo pi;
+  struct proc *p;
+  uint64 shared;
+  int i, got = 0;
+
+  if(q->version != PROCINFO_VERSION || q->slot < 0 || q->slot > NPROC || n < 0)
+    return -1;
+  if(q->slot == 0)
+    q->now = r_time();
+  for(i = q->slot; i < NPROC && got < n; i++){
+    p = &proc[i];
+    if(p->state != RUNNING && (p->changed <= q->since ||
+                               (q->since == 0 && p->state == UNUSED)))
+      continue;
+
+    acquire(&p->lock);
+    memset(&pi, 0, sizeof(pi));
+    pi.slot = i;
+    pi.pid = p->pid;
+    pi.ppid = p->parent ? p->parent->pid : 0;
+    pi.state = p->state;
+    safestrcpy(pi.name, p->name, sizeof(pi.name));
+    pi.tickets = p->tickets;
+    pi.ticks = p->ticks;
+    pi.cpu = p->lastcpu;
+    pi.utime = p->utime;
+    pi.stime = p->stime;
+    if(p->inuser)
+      pi.utime += unbilled(p, r_time());
+    else
+      pi.stime += unbilled(p, r_time());
+    pi.minflt = p->mstat.minflt;
+    pi.majflt = p->mstat.majflt;
+    // as in getmstat(), p->lock keeps the page table.
+    if((q->flags & PS_MEM) && p->state != UNUSED && p->pagetable)
+      uvmcount(p->pagetable, 2, &pi.rss, &shared);
+    pi.wchan = p->state == SLEEPING ? (uint64)p->chan : 0;
+    release(&p->lock);
+
+    if(copyout(myproc()->pagetable, buf + got * sizeof(pi), (char *)&pi, sizeof(pi)) < 0)
+      return -1;
+    got++;
+  }
+  q->slot = i < NPROC ? i : -1;
+  return got;
+}
+// - DEISO - P3
+
 // Print a process listing to console.  For debugging.
 // Runs when user types ^P on console.
 // No lock to avoid wedging a stuck machine further.
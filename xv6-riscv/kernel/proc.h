@@ -9,6 +9,11 @@
 #include "vma.h"
 // - DEISO - P2
 
+// + DEISO - P3
+#include "mstat.h"
+#include "sleeplock.h"
+// - DEISO - P3
+
 // Saved registers for kernel context switches.
 struct context {
   uint64 ra;
@@ -35,6 +40,19 @@ struct cpu {
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  // + DEISO - P3
+  pagetable_t kpagetable;     // This hart's kernel page table (UACCESS_SUM).
+  uint64 rtused;              // r_time() cycles given to real-time processes in rtwindow.
+  uint rtwindow;              // Current real-time throttling window.
+  uint64 nexttick;            // r_time() of this hart's next tick.
+  uint64 tlbgen;              // vmspace.tlbgen this hart's TLB is as new as.
+  int idle;                   // Waiting in wfi with nothing to run.
+  uint ticks;                 // Ticks this hart has taken.
+  uint64 utime;               // r_time() cycles run in user space,
+  uint64 stime;               // in the kernel for a process,
+  uint64 idletime;            // and in wfi, see cpuacct().
+  uint64 idlestart;           // r_time() it went idle at, or 0.
+  // - DEISO - P3
 };
 
 extern struct cpu cpus[NCPU];
@@ -105,14 +123,21 @@ struct proc {
 
   // wait_lock must be held when using this:
   struct proc *parent;         // Parent process
+  // + DEISO - P3
+  struct proc *children;       // Children that have not exited
+  struct proc *zombies;        // Exited children not yet waited for
+  struct proc *sibling;        // Next on the parent's children or zombies
+  struct proc **psibling;      // Link that points at p on that list
+  // - DEISO - P3
 
   // these are private to the process, so p->lock need not be held.
   uint64 kstack;               // Virtual address of kernel stack
-  uint64 sz;                   // Size of process memory (bytes)
   pagetable_t pagetable;       // User page table
   struct trapframe *trapframe; // data page for trampoline.S
   struct context context;      // swtch() here to run process
-  struct file *ofile[NOFILE];  // Open files
+  // + DEISO - P3
+  struct file **ofile;         // Open files, vs->ofile
+  // - DEISO - P3
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
 
@@ -122,8 +147,71 @@ struct proc {
   // - DEISO - P1
 
   // + DEISO - P2
-  struct mm mm;
+  // + DEISO - P3
+  struct mm *mm;               // vs->mm
+  // - DEISO - P3
   // - DEISO - P2
+
+  // + DEISO - P3
+  int stacklimit;              // Pages the user stack may grow to at exec
+  struct mstat mstat;          // Fault counters, only updated by the process itself
+  int weight;                  // Tickets in the lottery tree, under p->lock
+  int cpu;                     // Run queue p is on or last ran from, under p->lock
+  uint64 pass;                 // Stride scheduler's virtual time, under p->lock
+  int rtprio;                  // Real-time level, 0 for none
+  int used;                    // Percent of its last quantum used, under p->lock
+  int comp;                    // Compensation tickets until the next win, under p->lock
+  int group;                   // Ticket group, under p->lock
+  struct sleepq *sleepq;       // Sleep queue p is on, under its lock
+  struct proc *sqnext;         // Next on that sleep queue
+  struct timerq *timerq;       // Deadline queue p is on, under its lock
+  struct proc *tnext;          // Next on that deadline queue
+  uint64 deadline;             // r_time() to wake at, under timerq lock
+  struct proc *rtnext;         // Next in the real-time FIFO, under rtq.lock
+  struct proc *pidnext;        // Next in its pid hash bucket, under the bucket lock
+  struct proc *freenext;       // Next on the free list, under freelock
+  struct vmspace *vs;          // Address space and files, shared with threads
+  int tslot;                   // Trapframe slot in vs, see TRAPFRAMES()
+  uint64 quantum;              // Fixed slice from setquantum(), 0 for the default
+  uint64 slice;                // Slice of the current run, in timer cycles
+  uint64 nextslice;            // Slice ADAPTIVE would like to give next
+  int nvcsw;                   // Times p gave up the CPU to wait
+  int nivcsw;                  // Times p was preempted
+  uint64 affinity;             // Harts p may run on, one bit each, under p->lock
+  int lastcpu;                 // Hart p last ran on, or -1
+  int nmigrate;                // Times p ran on another hart than the last time
+  int skipped;                 // Left once for its last hart, see coldskip()
+  uint64 utime;                // r_time() cycles run in user space
+  uint64 stime;                // r_time() cycles run in the kernel
+  uint64 tstamp;               // r_time() the current stretch began at, see cpuacct()
+  int inuser;                  // The current stretch is in user space
+  uint64 changed;              // r_time() of the last change procstat() reports, under p->lock
+  // - DEISO - P3
+};
+
+// + DEISO - P3
+// What the threads made by clone() share: the user memory, that
+// is the page table and the mm that describes it, and the open
+// files. Every process has one, which may be shared with threads.
+// Each thread maps its own trapframe in the shared page table, at
+// TRAPFRAMES(p->tslot). A process changing the page table holds
+// mmlock, and calls tlbshootdown() before freeing anything the
+// other threads' harts may still reach through their TLBs; one
+// that holds spinlocks and so cannot take mmlock leaves the
+// mappings alone if it has other threads, see uvmaccess().
+// Takes one page, from kalloc().
+struct vmspace {
+  struct spinlock lock;        // protects ref, users, exiting, tslots and ofile[]
+  int ref;                     // procs using it, exited or not
+  int users;                   // threads that have not exited
+  int exiting;                 // the process is exiting, see vskill()
+  uint tslots;                 // trapframe slots in use, one bit each
+  uint64 tlbgen;               // bumped by each TLB shootdown
+  struct sleeplock mmlock;     // held while changing the mappings
+  uint64 sz;                   // size of the user memory, changed under mmlock
+  struct mm mm;
+  struct file *ofile[NOFILE];
 };
+// - DEISO - P3
 
 #endif // _PROC_H_
\ No newline at end of file
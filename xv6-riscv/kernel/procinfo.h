@@ -0,0 +1,46 @@
+// + DEISO - P3
+#ifndef _PROCINFO_H_
+#define _PROCINFO_H_
+
+#include "types.h"
+
+// Process statistics, see procstat(). A tool keeps its own copy
+// of the table, indexed by slot, and each poll brings over only
+// the slots that changed since the last one. Later versions
+// only add fields at the end.
+#define PROCINFO_VERSION 1
+
+// procquery.flags
+#define PS_MEM 0x1    // count resident pages, which walks the page table
+
+// What procstat() is to report, and where it got to.
+struct procquery {
+  int version;      // PROCINFO_VERSION the caller was built with
+  int flags;        // PS_ flags
+  int slot;         // first slot to look at, 0 to start a poll; set
+                    // to the slot to go on from, or -1 when done
+  uint64 since;     // only slots changed after this, 0 for all
+  uint64 now;       // set when a poll starts: its r_time(), the
+                    // since of the next poll
+};
+
+// One slot of the process table.
+struct procinfo {
+  int slot;
+  int pid;
+  int ppid;
+  int state;        // enum procstate, UNUSED once the process is gone
+  char name[16];
+  int tickets;
+  int ticks;        // times picked to run
+  int cpu;          // hart it last ran on, or -1
+  uint64 utime;     // r_time() cycles run in user space
+  uint64 stime;     // and in the kernel
+  uint64 minflt;    // page faults, see struct mstat
+  uint64 majflt;
+  uint64 rss;       // resident user pages, with PS_MEM
+  uint64 wchan;     // what it sleeps on, or 0
+};
+
+#endif // _PROCINFO_H_
+// - DEISO - P3
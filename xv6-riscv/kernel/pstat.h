@@ -8,7 +8,18 @@ struct pstat {
   int inuse[NPROC];   // whether this slot of the process table is in use (1 or 0)
   int tickets[NPROC]; // the number of tickets this process has
   int pid[NPROC];     // the PID of each process 
-  int ticks[NPROC];   // the number of ticks each process has accumulated 
+  int ticks[NPROC];   // the number of times each process was picked to run
+  // + DEISO - P3
+  int used[NPROC];    // percent of its last quantum the process used
+  int nvcsw[NPROC];   // times the process gave up the CPU to wait
+  int nivcsw[NPROC];  // times the process was preempted
+  int cpu[NPROC];     // hart the process last ran on, or -1
+  int nmigrate[NPROC]; // times it ran on another hart than the last time
+  uint64 affinity[NPROC]; // harts it may run on, one bit each
+  uint64 utime[NPROC]; // r_time() cycles it ran in user space
+  uint64 stime[NPROC]; // and in the kernel
+  char name[NPROC][16]; // its name
+  // - DEISO - P3
 };
 
 #endif // _PSTAT_H_
@@ -52,6 +52,9 @@ w_mepc(uint64 x)
 #define SSTATUS_UPIE (1L << 4) // User Previous Interrupt Enable
 #define SSTATUS_SIE (1L << 1)  // Supervisor Interrupt Enable
 #define SSTATUS_UIE (1L << 0)  // User Interrupt Enable
+// + DEISO - P3
+#define SSTATUS_SUM (1L << 18) // Supervisor may access User memory
+// - DEISO - P3
 
 static inline uint64
 r_sstatus()
@@ -247,6 +250,15 @@ r_satp()
   return x;
 }
 
+// + DEISO - P3
+// Supervisor Scratch register, for trampoline.S
+static inline void 
+w_sscratch(uint64 x)
+{
+  asm volatile("csrw sscratch, %0" : : "r" (x));
+}
+// - DEISO - P3
+
 // Supervisor Trap Cause
 static inline uint64
 r_scause()
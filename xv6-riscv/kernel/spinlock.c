@@ -7,6 +7,59 @@
 #include "riscv.h"
 #include "proc.h"
 #include "defs.h"
+// + DEISO - P3
+#include "irqstat.h"
+
+#ifdef IRQTRACE
+// Interrupts-off tracer. Every stretch a hart spends with
+// interrupts off, from the outermost push_off() to the pop_off()
+// that turns them back on, is timed with r_time() and goes into
+// the hart's histogram; the longest one of each caller is kept
+// for the worst NIRQWORST callers. A stretch begun with
+// interrupts already off, as in a trap handler, is not timed.
+// Each hart only writes its own record, with interrupts off.
+struct irqtrace {
+  uint64 start;             // r_time() of the outermost push_off(), or 0
+  uint64 pc;                // who called it
+  char *lock;               // the lock acquire() took with it, or 0
+  uint64 hist[NIRQHIST];
+  struct {
+    uint64 pc;
+    uint64 cycles;
+    char *lock;
+  } worst[NIRQWORST];
+} irqtrace[NCPU];
+
+// Record a stretch of d cycles. Interrupts must be off.
+static void
+irqrecord(struct irqtrace *t, uint64 d)
+{
+  uint64 us = d / (TIMEBASE / 1000000);
+  int b = 0, min = 0;
+
+  while(b < NIRQHIST - 1 && us >= (2UL << b))
+    b++;
+  t->hist[b]++;
+
+  for(int i = 0; i < NIRQWORST; i++){
+    if(t->worst[i].pc == t->pc){
+      if(d > t->worst[i].cycles){
+        t->worst[i].cycles = d;
+        t->worst[i].lock = t->lock;
+      }
+      return;
+    }
+    if(t->worst[i].cycles < t->worst[min].cycles)
+      min = i;
+  }
+  if(d > t->worst[min].cycles){
+    t->worst[min].pc = t->pc;
+    t->worst[min].cycles = d;
+    t->worst[min].lock = t->lock;
+  }
+}
+#endif
+// - DEISO - P3
 
 void
 initlock(struct spinlock *lk, char *name)
@@ -40,6 +93,17 @@ acquire(struct spinlock *lk)
 
   // Record info about lock acquisition for holding() and debugging.
   lk->cpu = mycpu();
+
+  // + DEISO - P3
+#ifdef IRQTRACE
+  // charge the stretch this began to our caller, not to acquire().
+  if(lk->cpu->noff == 1){
+    struct irqtrace *t = &irqtrace[cpuid()];
+    t->pc = (uint64)__builtin_return_address(0);
+    t->lock = lk->name;
+  }
+#endif
+  // - DEISO - P3
 }
 
 // Release the lock.
@@ -91,8 +155,17 @@ push_off(void)
   int old = intr_get();
 
   intr_off();
-  if(mycpu()->noff == 0)
+  if(mycpu()->noff == 0){
     mycpu()->intena = old;
+    // + DEISO - P3
+#ifdef IRQTRACE
+    struct irqtrace *t = &irqtrace[cpuid()];
+    t->start = old ? r_time() : 0;
+    t->pc = (uint64)__builtin_return_address(0);
+    t->lock = 0;
+#endif
+    // - DEISO - P3
+  }
   mycpu()->noff += 1;
 }
 
@@ -105,6 +178,53 @@ pop_off(void)
   if(c->noff < 1)
     panic("pop_off");
   c->noff -= 1;
+  // + DEISO - P3
+#ifdef IRQTRACE
+  if(c->noff == 0 && c->intena){
+    struct irqtrace *t = &irqtrace[cpuid()];
+    if(t->start)
+      irqrecord(t, r_time() - t->start);
+    t->start = 0;
+  }
+#endif
+  // - DEISO - P3
   if(c->noff == 0 && c->intena)
     intr_on();
 }
+
+// + DEISO - P3
+// Copy out the interrupts-off records of every hart to the
+// struct irqstat at user address addr, and clear them if reset
+// is set. Reads the other harts' records without stopping them,
+// so a record made meanwhile may be torn, or survive a reset.
+// Returns -1 unless the kernel was built with make IRQTRACE=1.
+int
+irqstat(uint64 addr, int reset)
+{
+#ifdef IRQTRACE
+  struct irqcpu ic;
+
+  for(int i = 0; i < NCPU; i++){
+    struct irqtrace *t = &irqtrace[i];
+
+    memmove(ic.hist, t->hist, sizeof(ic.hist));
+    for(int w = 0; w < NIRQWORST; w++){
+      ic.worst[w].pc = t->worst[w].pc;
+      ic.worst[w].cycles = t->worst[w].cycles;
+      ic.worst[w].lock[0] = 0;
+      if(t->worst[w].lock)
+        safestrcpy(ic.worst[w].lock, t->worst[w].lock, sizeof(ic.worst[w].lock));
+    }
+    if(reset){
+      memset(t->hist, 0, sizeof(t->hist));
+      memset(t->worst, 0, sizeof(t->worst));
+    }
+    if(copyout(myproc()->pagetable, addr + i * sizeof(ic), (char *)&ic, sizeof(ic)) < 0)
+      return -1;
+  }
+  return 0;
+#else
+  return -1;
+#endif
+}
+// - DEISO - P3
@@ -62,5 +62,7 @@ timerinit()
   w_mcounteren(r_mcounteren() | 2);
   
   // ask for the very first timer interrupt.
-  w_stimecmp(r_time() + 1000000);
+  // + DEISO - P3
+  w_stimecmp(r_time() + QUANTUM);
+  // - DEISO - P3
 }
@@ -12,8 +12,11 @@ int
 fetchaddr(uint64 addr, uint64 *ip)
 {
   struct proc *p = myproc();
-  if(addr >= p->sz || addr+sizeof(uint64) > p->sz) // both tests needed, in case of overflow
+  // + DEISO - P3
+  uint64 sz = p->vs->sz;
+  if(addr >= sz || addr+sizeof(uint64) > sz) // both tests needed, in case of overflow
     return -1;
+  // - DEISO - P3
   if(copyin(p->pagetable, (char *)ip, addr, sizeof(*ip)) != 0)
     return -1;
   return 0;
@@ -112,6 +115,23 @@ extern uint64 sys_mmap(void);
 extern uint64 sys_munmap(void);
 // - DEISO - P2
 
+// + DEISO - P3
+extern uint64 sys_setstacklimit(void);
+extern uint64 sys_getmstat(void);
+extern uint64 sys_setrtprio(void);
+extern uint64 sys_mkgroup(void);
+extern uint64 sys_getgstat(void);
+extern uint64 sys_msleep(void);
+extern uint64 sys_setquantum(void);
+extern uint64 sys_clone(void);
+extern uint64 sys_join(void);
+extern uint64 sys_futex(void);
+extern uint64 sys_setaffinity(void);
+extern uint64 sys_getcpustat(void);
+extern uint64 sys_procstat(void);
+extern uint64 sys_irqstat(void);
+// - DEISO - P3
+
 // An array mapping syscall numbers from syscall.h
 // to the function that handles the system call.
 static uint64 (*syscalls[])(void) = {
@@ -146,6 +166,23 @@ static uint64 (*syscalls[])(void) = {
 [SYS_mmap] sys_mmap,
 [SYS_munmap] sys_munmap,
 // - DEISO - P2
+
+// + DEISO - P3
+[SYS_setstacklimit] sys_setstacklimit,
+[SYS_getmstat] sys_getmstat,
+[SYS_setrtprio] sys_setrtprio,
+[SYS_mkgroup] sys_mkgroup,
+[SYS_getgstat] sys_getgstat,
+[SYS_msleep] sys_msleep,
+[SYS_setquantum] sys_setquantum,
+[SYS_clone] sys_clone,
+[SYS_join] sys_join,
+[SYS_futex] sys_futex,
+[SYS_setaffinity] sys_setaffinity,
+[SYS_getcpustat] sys_getcpustat,
+[SYS_procstat] sys_procstat,
+[SYS_irqstat] sys_irqstat,
+// - DEISO - P3
 };
 
 void
@@ -34,4 +34,21 @@
 #define SYS_munmap 25
 // - DEISO - P2
 
+// + DEISO - P3
+#define SYS_setstacklimit 26
+#define SYS_getmstat 27
+#define SYS_setrtprio 28
+#define SYS_mkgroup 29
+#define SYS_getgstat 30
+#define SYS_msleep 31
+#define SYS_setquantum 32
+#define SYS_clone 33
+#define SYS_join 34
+#define SYS_futex 35
+#define SYS_setaffinity 36
+#define SYS_getcpustat 37
+#define SYS_procstat 38
+#define SYS_irqstat 39
+// - DEISO - P3
+
 #endif // __SYSCALL_H__
\ No newline at end of file
@@ -42,12 +42,22 @@ fdalloc(struct file *f)
   int fd;
   struct proc *p = myproc();
 
+  // + DEISO - P3
+  // The table is shared with our threads.
+  acquire(&p->vs->lock);
+  // - DEISO - P3
   for(fd = 0; fd < NOFILE; fd++){
     if(p->ofile[fd] == 0){
       p->ofile[fd] = f;
+      // + DEISO - P3
+      release(&p->vs->lock);
+      // - DEISO - P3
       return fd;
     }
   }
+  // + DEISO - P3
+  release(&p->vs->lock);
+  // - DEISO - P3
   return -1;
 }
 
@@ -107,7 +117,17 @@ sys_close(void)
 
   if(argfd(0, &fd, &f) < 0)
     return -1;
+  // + DEISO - P3
+  // Only one of several threads closing fd gets to close f.
+  struct vmspace *vs = myproc()->vs;
+  acquire(&vs->lock);
+  if(myproc()->ofile[fd] != f){
+    release(&vs->lock);
+    return -1;
+  }
   myproc()->ofile[fd] = 0;
+  release(&vs->lock);
+  // - DEISO - P3
   fileclose(f);
   return 0;
 }
@@ -544,7 +564,11 @@ sys_mmap(void)
     return -1;
   }
 
-  uint64 res = (uint64)create_vma_file(&myproc()->mm, len, f, 0, prot, flags);
+  // + DEISO - P3
+  int locked = vmlock(myproc());
+  uint64 res = (uint64)create_vma_file(myproc()->mm, len, f, 0, prot, flags);
+  if (locked) vmunlock(myproc());
+  // - DEISO - P3
 
   return res;
 }
@@ -566,7 +590,11 @@ sys_munmap(void)
     return -1;
   }
 
-  int res = delete_vma(&myproc()->mm, myproc()->pagetable, addr, len);
+  // + DEISO - P3
+  int locked = vmlock(myproc());
+  int res = delete_vma(myproc()->mm, myproc()->pagetable, addr, len);
+  if (locked) vmunlock(myproc());
+  // - DEISO - P3
 
   return res;
 }
@@ -10,6 +10,13 @@
 #include "pstat.h"
 // - DEISO - P1
 
+// + DEISO - P3
+#include "gstat.h"
+#include "cpustat.h"
+#include "procinfo.h"
+#include "fcntl.h"
+// - DEISO - P3
+
 uint64
 sys_exit(void)
 {
@@ -46,7 +53,9 @@ sys_sbrk(void)
   int n;
 
   argint(0, &n);
-  addr = myproc()->sz;
+  // + DEISO - P3
+  addr = myproc()->vs->sz;
+  // - DEISO - P3
   if(growproc(n) < 0)
     return -1;
   return addr;
@@ -56,22 +65,13 @@ uint64
 sys_sleep(void)
 {
   int n;
-  uint ticks0;
 
   argint(0, &n);
   if(n < 0)
     n = 0;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(killed(myproc())){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
+  // + DEISO - P3
+  return timersleep(r_time() + (uint64)n * QUANTUM);
+  // - DEISO - P3
 }
 
 uint64
@@ -90,6 +90,9 @@ sys_uptime(void)
 {
   uint xticks;
 
+  // + DEISO - P3
+  tickupdate();
+  // - DEISO - P3
   acquire(&tickslock);
   xticks = ticks;
   release(&tickslock);
@@ -105,26 +108,273 @@ sys_settickets(void)
 
   if (tickets < 1)
     return -1;
-  myproc()->tickets = tickets;
+  // + DEISO - P3
+  // keep the sum over all processes from overflowing the
+  // scheduler's ticket trees.
+  if (tickets > MAXTICKETS)
+    return -1;
+  settickets(tickets);
+  // - DEISO - P3
   return 0;
 }
 
 uint64 
 sys_getpinfo(void)
 {
-  struct pstat pstat; //En kernel
   uint64 upstat; //Dirección del pstat que se ha pasado. En usuario
+  int r = 0;
   argaddr(0, &upstat); 
   if (&upstat <= 0)
     return -1;
 
+  // + DEISO - P3
+  acquiresleep(&pstatlock);
+  // - DEISO - P3
   getpinfo(&pstat); //Se ha rellenado pstat con los datos en el kernel
   // + DEISO - P2
   walkaddr(myproc()->pagetable, upstat);
   // - DEISO - P2
   if(copyout(myproc()->pagetable, upstat, (char *)&pstat,sizeof(pstat)) < 0) // Copiamos la pstat desde el kernel al espacio de usuario
+      r = -1;
+  // + DEISO - P3
+  releasesleep(&pstatlock);
+  // - DEISO - P3
+
+  return r;
+}
+// - DEISO - P1
+
+// + DEISO - P3
+// Set how many pages the user stack may grow to. Like an rlimit,
+// it takes effect at the next exec() and is inherited by fork().
+uint64
+sys_setstacklimit(void)
+{
+  int pages;
+  argint(0, &pages);
+
+  if(pages < USERSTACK || pages > MAXUSERSTACK)
+    return -1;
+  myproc()->stacklimit = pages;
+  return 0;
+}
+
+uint64
+sys_getmstat(void)
+{
+  int pid;
+  uint64 addr;
+  struct mstat st;
+
+  argint(0, &pid);
+  argaddr(1, &addr);
+
+  if(getmstat(pid, &st) < 0)
+    return -1;
+  if(copyout(myproc()->pagetable, addr, (char *)&st, sizeof(st)) < 0)
+    return -1;
+  return 0;
+}
+
+// Move the caller into real-time level prio, 1..NRTPRIO, where
+// it runs ahead of every normal process; 0 moves it back.
+// Inherited by fork().
+uint64
+sys_setrtprio(void)
+{
+  int prio;
+  argint(0, &prio);
+
+  if(prio < 0 || prio > NRTPRIO)
+    return -1;
+  setrtprio(prio);
+  return 0;
+}
+
+// Give the caller a fixed time slice of us microseconds,
+// MINQUANTUM..MAXQUANTUM; 0 goes back to the scheduler's
+// default. Inherited by fork().
+uint64
+sys_setquantum(void)
+{
+  int us;
+  uint64 q;
+  argint(0, &us);
+
+  q = (uint64)us * (TIMEBASE / 1000000);
+  if(us < 0 || (us > 0 && (q < MINQUANTUM || q > MAXQUANTUM)))
+    return -1;
+  myproc()->quantum = q;
+  return 0;
+}
+
+// Sleep for n milliseconds, to the resolution of the timer
+// rather than of the tick.
+uint64
+sys_msleep(void)
+{
+  int n;
+
+  argint(0, &n);
+  if(n < 0)
+    n = 0;
+  return timersleep(r_time() + (uint64)n * (TIMEBASE / 1000));
+}
+
+// Put the caller in a new ticket group funded with tickets
+// base tickets; returns the group id. See proc.c.
+uint64
+sys_mkgroup(void)
+{
+  int tickets;
+  argint(0, &tickets);
+
+  if(tickets < 1 || tickets > MAXTICKETS)
+    return -1;
+  return mkgroup(tickets);
+}
+
+uint64
+sys_getgstat(void)
+{
+  int gid;
+  uint64 addr;
+  struct gstat st;
+
+  argint(0, &gid);
+  argaddr(1, &addr);
+
+  if(getgstat(gid, &st) < 0)
+    return -1;
+  if(copyout(myproc()->pagetable, addr, (char *)&st, sizeof(st)) < 0)
+    return -1;
+  return 0;
+}
+
+// Start a thread running fn(arg) on the stack that ends at
+// stack, sharing the caller's memory and files; returns its
+// pid. See proc.c.
+uint64
+sys_clone(void)
+{
+  uint64 fn, arg, stack;
+
+  argaddr(0, &fn);
+  argaddr(1, &arg);
+  argaddr(2, &stack);
+
+  if(stack % 16 != 0 || stack == 0 || stack > USERTOP)
+    return -1;
+  return clone(fn, arg, stack);
+}
+
+// Wait for thread tid, or any thread if tid is -1, to exit;
+// returns its pid.
+uint64
+sys_join(void)
+{
+  int tid;
+
+  argint(0, &tid);
+  return join(tid);
+}
+
+// futex(addr, FUTEX_WAIT, val) sleeps while the int at addr is
+// val; futex(addr, FUTEX_WAKE, n) wakes up to n of the sleepers
+// and returns how many. Threads meet on the address, processes
+// sharing a MAP_SHARED page on its physical address. See proc.c.
+uint64
+sys_futex(void)
+{
+  uint64 addr, pa;
+  int op, val, shared;
+  void *chan;
+
+  argaddr(0, &addr);
+  argint(1, &op);
+  argint(2, &val);
+
+  if(addr % sizeof(int) != 0)
+    return -1;
+  if((pa = uvmphys(myproc()->pagetable, addr, &shared)) == 0)
+    return -1;
+  chan = futexchan(addr, pa, shared);
+  switch(op){
+  case FUTEX_WAIT:
+    return futexwait(chan, addr, val);
+  case FUTEX_WAKE:
+    if(val < 0)
       return -1;
+    return futexwake(chan, val);
+  }
+  return -1;
+}
 
+// Restrict process pid, or the caller if pid is 0, to the harts
+// whose bits are set in mask. See proc.c.
+uint64
+sys_setaffinity(void)
+{
+  int pid;
+  uint64 mask;
+
+  argint(0, &pid);
+  argaddr(1, &mask);
+
+  if(pid < 0)
+    return -1;
+  return setaffinity(pid, mask);
+}
+
+// Copy out how each hart has spent its time. See proc.c.
+uint64
+sys_getcpustat(void)
+{
+  uint64 addr;
+  struct cpustat st;
+
+  argaddr(0, &addr);
+
+  getcpustat(&st);
+  if(copyout(myproc()->pagetable, addr, (char *)&st, sizeof(st)) < 0)
+    return -1;
   return 0;
 }
-// - DEISO - P1
\ No newline at end of file
+
+// Copy out the process table slots the query asks for, and the
+// query updated to go on from where it stopped. See proc.c.
+uint64
+sys_procstat(void)
+{
+  uint64 qaddr, buf;
+  int n, got;
+  struct procquery q;
+  struct proc *p = myproc();
+
+  argaddr(0, &qaddr);
+  argaddr(1, &buf);
+  argint(2, &n);
+
+  if(copyin(p->pagetable, (char *)&q, qaddr, sizeof(q)) < 0)
+    return -1;
+  if((got = procstat(&q, buf, n)) < 0)
+    return -1;
+  if(copyout(p->pagetable, qaddr, (char *)&q, sizeof(q)) < 0)
+    return -1;
+  return got;
+}
+
+// Copy out the interrupts-off tracer's records, and clear them
+// if reset is set. See spinlock.c.
+uint64
+sys_irqstat(void)
+{
+  uint64 addr;
+  int reset;
+
+  argaddr(0, &addr);
+  argint(1, &reset);
+
+  return irqstat(addr, reset);
+}
+// - DEISO - P3
@@ -0,0 +1,125 @@
+// + DEISO - P3
+// Timed sleep.
+//
+// A process that sleeps for a while goes on the deadline queue
+// of the hart it slept on, sorted by the r_time() at which it
+// must wake. clockintr() wakes the expired ones and programs
+// the hart's timer for the earlier of the next tick and the
+// next deadline, so sleepers wake exactly when they are due,
+// to the resolution of the timer, and nobody else is woken.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+
+struct timerq {
+  struct spinlock lock;
+  struct proc *head;        // sorted by p->deadline
+  uint64 next;              // head's deadline, or ~0
+} timerq[NCPU];
+
+void
+timerinit(void)
+{
+  for(int i = 0; i < NCPU; i++){
+    initlock(&timerq[i].lock, "timerq");
+    timerq[i].next = ~0UL;
+  }
+}
+
+// The next deadline on this hart's queue, or ~0. Peeks
+// without the lock: at worst the timer fires for nothing.
+// Interrupts must be off.
+uint64
+timernext(void)
+{
+  return timerq[cpuid()].next;
+}
+
+// Take p off q if it is still there. Caller must hold q->lock.
+static void
+timer_remove(struct timerq *q, struct proc *p)
+{
+  struct proc **pp;
+
+  for(pp = &q->head; *pp; pp = &(*pp)->tnext){
+    if(*pp == p){
+      *pp = p->tnext;
+      break;
+    }
+  }
+  p->timerq = 0;
+  q->next = q->head ? q->head->deadline : ~0UL;
+}
+
+// Sleep until r_time() reaches deadline.
+// Returns -1 if the process was killed first.
+int
+timersleep(uint64 deadline)
+{
+  struct proc *p = myproc();
+  struct timerq *q;
+  struct proc **pp;
+  int r = 0;
+
+  if(deadline <= r_time())
+    return 0;
+
+  // q->lock keeps interrupts off, so we stay on this hart
+  // until p is queued and the timer set.
+  push_off();
+  q = &timerq[cpuid()];
+  acquire(&q->lock);
+  pop_off();
+
+  p->deadline = deadline;
+  for(pp = &q->head; *pp && (*pp)->deadline <= deadline; pp = &(*pp)->tnext)
+    ;
+  p->tnext = *pp;
+  *pp = p;
+  p->timerq = q;
+  if(q->head == p){
+    q->next = deadline;
+    if(deadline < mycpu()->nexttick)
+      w_stimecmp(deadline);
+  }
+
+  while(p->timerq){
+    if(killed(p)){
+      timer_remove(q, p);
+      r = -1;
+      break;
+    }
+    sleep(&p->deadline, &q->lock);
+  }
+  release(&q->lock);
+  return r;
+}
+
+// Wake the sleepers on this hart's queue whose deadline has
+// passed, and set *next to the next deadline, or ~0 if none is
+// left. Returns 1 if it woke anyone.
+// Called from clockintr() with interrupts off.
+int
+timerexpire(uint64 now, uint64 *next)
+{
+  struct timerq *q = &timerq[cpuid()];
+  struct proc *p;
+  int woke = 0;
+
+  acquire(&q->lock);
+  while((p = q->head) != 0 && p->deadline <= now){
+    q->head = p->tnext;
+    p->timerq = 0;
+    wakeup(&p->deadline);
+    woke = 1;
+  }
+  *next = q->next = p ? p->deadline : ~0UL;
+  release(&q->lock);
+  return woke;
+}
+// - DEISO - P3
@@ -21,9 +21,16 @@ void kernelvec();
 
 extern int devintr();
 
+// + DEISO - P3
+static uint64 boottime;  // r_time() at trapinit()
+// - DEISO - P3
+
 void trapinit(void)
 {
   initlock(&tickslock, "time");
+  // + DEISO - P3
+  boottime = r_time();
+  // - DEISO - P3
 }
 
 // set up to take exceptions and traps while in the kernel.
@@ -49,6 +56,11 @@ void usertrap(void)
 
   struct proc *p = myproc();
 
+  // + DEISO - P3
+  // interrupts are still off.
+  cpuacct(p, 0);
+  // - DEISO - P3
+
   // save user program counter.
   p->trapframe->epc = r_sepc();
 
@@ -78,14 +90,22 @@ void usertrap(void)
   else if (r_scause() == 12 || r_scause() == 13)
   {
     uint64 fail_addr = r_stval();
-    if (alloc_vma(&p->mm, p->pagetable, fail_addr) == -1)
+    // + DEISO - P3
+    int locked = vmlock(p);
+    if (alloc_vma(p->mm, p->pagetable, fail_addr) == -1)
     {
       setkilled(p);
     }
+    if (locked)
+      vmunlock(p);
+    // - DEISO - P3
   }
   // Write page faults.
   else if (r_scause() == 15) {
     uint64 fail_addr = r_stval();
+    // + DEISO - P3
+    int locked = vmlock(p);
+    // - DEISO - P3
     int res = copy_on_write(p->pagetable, fail_addr);
 
     // Check if copy-on-write failed.
@@ -93,9 +113,13 @@ void usertrap(void)
       setkilled(p);
     }
     // If there was no cow try allocating a mapping for that address.
-    else if (res == 0 && alloc_vma(&p->mm, p->pagetable, fail_addr) == -1) {
+    else if (res == 0 && alloc_vma(p->mm, p->pagetable, fail_addr) == -1) {
       setkilled(p);
     }
+    // + DEISO - P3
+    if (locked)
+      vmunlock(p);
+    // - DEISO - P3
   }
   // - DEISO - P2
   else
@@ -153,6 +177,14 @@ void usertrapret(void)
   // tell trampoline.S the user page table to switch to.
   uint64 satp = MAKE_SATP(p->pagetable);
 
+  // + DEISO - P3
+  // and where this thread's trapframe is mapped in it.
+  w_sscratch(TRAPFRAMES(p->tslot));
+  // userret flushes the TLB once it is on the user page table.
+  tlback(p);
+  cpuacct(p, 1);
+  // - DEISO - P3
+
   // jump to userret in trampoline.S at the top of memory, which
   // switches to the user page table, restores user registers,
   // and switches to user mode with sret.
@@ -174,6 +206,20 @@ void kerneltrap()
   if (intr_get() != 0)
     panic("kerneltrap: interrupts enabled");
 
+  // + DEISO - P3
+  // Page faults in the user access routines of uaccess.S resume
+  // at their fixup, which makes the copy fail.
+  if (scause == 13 || scause == 15)
+  {
+    uint64 fixup = uaccess_fixup(sepc);
+    if (fixup != 0)
+    {
+      w_sepc(fixup);
+      return;
+    }
+  }
+  // - DEISO - P3
+
   if ((which_dev = devintr()) == 0)
   {
     // interrupt or trap from an unknown source
@@ -191,21 +237,146 @@ void kerneltrap()
   w_sstatus(sstatus);
 }
 
-void clockintr()
+// + DEISO - P3
+// A hart's "tick" is the end of the running process's time
+// slice, p->slice timer cycles after it was picked, so harts
+// no longer tick in step or every QUANTUM. The global ticks
+// still count QUANTUMs since boot.
+
+// Bring ticks up to date with r_time(). No hart is sure to see
+// every tick any more, so whoever looks works them out from
+// the clock.
+void tickupdate(void)
 {
-  if (cpuid() == 0)
+  uint t = (r_time() - boottime) / QUANTUM;
+
+  if (t == ticks)
+    return;
+  acquire(&tickslock);
+  if (t > ticks)
   {
-    acquire(&tickslock);
-    ticks++;
+    ticks = t;
     wakeup(&ticks);
-    release(&tickslock);
   }
+  release(&tickslock);
+}
+
+// Program the timer for the earlier of this hart's tick and
+// its next deadline.
+static void clockset(struct cpu *c)
+{
+  uint64 next = timernext();
+
+  w_stimecmp(next < c->nexttick ? next : c->nexttick);
+}
+
+// Length of the slice running on this hart.
+static uint64 curslice(struct cpu *c)
+{
+  return c->proc ? c->proc->slice : QUANTUM;
+}
+
+// Start a slice of n timer cycles for the process the scheduler
+// is about to run. Interrupts must be off.
+void clockslice(uint64 n)
+{
+  struct cpu *c = mycpu();
+
+  c->nexttick = r_time() + n;
+  clockset(c);
+}
+
+#ifdef TICKLESS
+// Tickless mode: a hart only ticks while it has something to
+// preempt (see needtick()), and an idle hart sleeps until its
+// next deadline, looking for work to steal every IDLEPOLL
+// ticks. cpu.nexttick is ~0 while the tick is stopped.
+
+// Restart this hart's tick if it was stopped, because a
+// process may now be waiting for the CPU.
+// Interrupts must be off.
+void clockarm(void)
+{
+  struct cpu *c = mycpu();
+
+  if (c->nexttick == ~0UL)
+  {
+    c->nexttick = r_time() + curslice(c);
+    clockset(c);
+  }
+}
+
+// The scheduler found nothing to run: stop ticking.
+// Interrupts must be off.
+void clockidle(void)
+{
+  struct cpu *c = mycpu();
+
+  c->idle = 1;
+  c->nexttick = r_time() + IDLEPOLL * QUANTUM;
+  clockset(c);
+}
+
+// The scheduler is about to look for work again; tick until
+// clockintr() finds the tick is not needed.
+// Interrupts must be off.
+void clockbusy(void)
+{
+  struct cpu *c = mycpu();
+
+  c->idle = 0;
+  c->nexttick = ~0UL;
+  clockarm();
+}
+#endif
+
+// A timer interrupt is either the hart's tick or a sleeper's
+// deadline (see timer.c). Returns 1 if it was a tick or woke
+// someone, so that the running process should yield.
+int clockintr()
+{
+  struct cpu *c = mycpu();
+  uint64 now = r_time(), next;
+  int tick = 0;
+
+  if (now >= c->nexttick)
+  {
+    tickupdate();
+    c->ticks++;
+#ifdef TICKLESS
+    if (c->idle)
+      c->nexttick = now + IDLEPOLL * QUANTUM;
+    else if (needtick())
+      c->nexttick = now + curslice(c);
+    else
+      c->nexttick = ~0UL;
+#else
+    c->nexttick = now + curslice(c);
+#endif
+    tick = 1;
+  }
+  if (timerexpire(now, &next))
+    tick = 1;
 
   // ask for the next timer interrupt. this also clears
-  // the interrupt request. 1000000 is about a tenth
-  // of a second.
-  w_stimecmp(r_time() + 1000000);
+  // the interrupt request.
+  w_stimecmp(next < c->nexttick ? next : c->nexttick);
+  return tick;
 }
+// - DEISO - P3
+
+// + DEISO - P3
+// Inter-processor interrupts: raise a supervisor software
+// interrupt on another hart, to get it out of wfi or make it
+// trap from user space. Does nothing without make IPI=1.
+void
+ipi_send(int hart)
+{
+#ifdef IPI
+  *(volatile uint32 *)SSWI_SETSSIP(hart) = 1;
+#endif
+}
+// - DEISO - P3
 
 // check if it's an external interrupt or software interrupt,
 // and handle it.
@@ -244,11 +415,23 @@ int devintr()
 
     return 1;
   }
+  // + DEISO - P3
+  else if (scause == 0x8000000000000001L)
+  {
+    // supervisor software interrupt: an IPI from ipi_send().
+    // there is nothing to do but return, to scheduler() out
+    // of wfi, or through usertrapret().
+    w_sip(r_sip() & ~2);
+    return 1;
+  }
+  // - DEISO - P3
   else if (scause == 0x8000000000000005L)
   {
     // timer interrupt.
-    clockintr();
-    return 2;
+    // + DEISO - P3
+    // a deadline that woke nobody is not worth a yield.
+    return clockintr() ? 2 : 1;
+    // - DEISO - P3
   }
   else
   {
@@ -19,6 +19,19 @@ extern char etext[];  // kernel.ld sets this to end of kernel code.
 
 extern char trampoline[]; // trampoline.S
 
+// + DEISO - P3
+static int cowpte(pagetable_t, pte_t *);
+static void freewalk_batch(pagetable_t, void **);
+static pte_t *uvmaccess(pagetable_t, uint64, int);
+static pte_t *uvmstep(pagetable_t, pte_t *, uint64, int);
+static char *uvmrange(pagetable_t, uint64, uint64, int, pte_t **, uint64 *);
+#ifdef UACCESS_SUM
+static int uaccess_ok(pagetable_t, uint64, uint64);
+int uaccess_copy(char *, char *, uint64);
+int uaccess_copystr(char *, char *, uint64);
+#endif
+// - DEISO - P3
+
 // Make a direct-map page table for the kernel.
 pagetable_t
 kvmmake(void)
@@ -37,6 +50,13 @@ kvmmake(void)
   // PLIC
   kvmmap(kpgtbl, PLIC, PLIC, 0x4000000, PTE_R | PTE_W);
 
+  // + DEISO - P3
+#ifdef IPI
+  // inter-processor interrupts
+  kvmmap(kpgtbl, SSWI, SSWI, SSWI_SIZE, PTE_R | PTE_W);
+#endif
+  // - DEISO - P3
+
   // map kernel text executable and read-only.
   kvmmap(kpgtbl, KERNBASE, KERNBASE, (uint64)etext-KERNBASE, PTE_R | PTE_X);
 
@@ -65,10 +85,31 @@ kvminit(void)
 void
 kvminithart()
 {
+  // + DEISO - P3
+#ifdef UACCESS_SUM
+  // Each hart runs on its own copy of the root page-table page,
+  // sharing everything below it, so that the upper half can alias
+  // the user space of whichever process the hart is running.
+  struct cpu *c = mycpu();
+  if(c->kpagetable == 0){
+    if((c->kpagetable = (pagetable_t) kalloc()) == 0)
+      panic("kvminithart");
+    memmove(c->kpagetable, kernel_pagetable, PGSIZE);
+    memset(&c->kpagetable[PX(2, USERALIAS)], 0, PGSIZE / 2);
+  }
+#endif
+  // - DEISO - P3
+
   // wait for any previous writes to the page table memory to finish.
   sfence_vma();
 
+  // + DEISO - P3
+#ifdef UACCESS_SUM
+  w_satp(MAKE_SATP(c->kpagetable));
+#else
   w_satp(MAKE_SATP(kernel_pagetable));
+#endif
+  // - DEISO - P3
 
   // flush stale entries from the TLB.
   sfence_vma();
@@ -113,22 +154,13 @@ uint64
 walkaddr(pagetable_t pagetable, uint64 va)
 {
   pte_t *pte;
-  uint64 pa;
 
-  if(va >= MAXVA)
-    return 0;
-
-  pte = walk(pagetable, va, 0);
-  // + DEISO - P2
-  // IF kernel tries to access pages yet to be mapped it should try to allocate using the VMA.
-  if(pte == 0 || (*pte & PTE_V) == 0)
-    if (alloc_vma(&myproc()->mm, pagetable, va) < 0) 
-      return 0;
-  // - DEISO - P2
-  if((*pte & PTE_U) == 0)
+  // + DEISO - P3
+  // uvmaccess() also faults in pages of a VMA yet to be mapped.
+  if((pte = uvmaccess(pagetable, va, 0)) == 0)
     return 0;
-  pa = PTE2PA(*pte);
-  return pa;
+  // - DEISO - P3
+  return PTE2PA(*pte);
 }
 
 // add a mapping to the kernel page table.
@@ -188,6 +220,9 @@ uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
 {
   uint64 a;
   pte_t *pte;
+  // + DEISO - P3
+  void *batch = 0;
+  // - DEISO - P3
 
   if((va % PGSIZE) != 0)
     panic("uvmunmap: not aligned");
@@ -208,14 +243,20 @@ uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
       panic("uvmunmap: not a leaf");
     if(do_free){
       uint64 pa = PTE2PA(*pte);
-      // + DEISO - P2
-      // Check reference counting before freeing memory.
-      if (getref((void *) pa) == 1) kfree((void*)pa);
-      else decref((void *) pa);
-      // - DEISO - P2
+      // + DEISO - P3
+      // Drop our reference; the last one frees the page, in one
+      // batch with the rest.
+      kput(&batch, (void *)pa);
+      // - DEISO - P3
     }
     *pte = 0;
   }
+  // + DEISO - P3
+  uvmflush(pagetable);
+  if(batch && tlbshootdown(pagetable) == 0)
+    panic("uvmunmap: shootdown");
+  kfreebatch(batch);
+  // - DEISO - P3
 }
 
 // create an empty user page table.
@@ -293,35 +334,45 @@ uvmdealloc(pagetable_t pagetable, uint64 oldsz, uint64 newsz)
   return newsz;
 }
 
-// Recursively free page-table pages.
-// All leaf mappings must already have been removed.
+// Free user memory pages,
+// then free page-table pages.
 void
-freewalk(pagetable_t pagetable)
+uvmfree(pagetable_t pagetable, uint64 sz)
+{
+  // + DEISO - P3
+  // Rather than walking from the root for every page below sz,
+  // visit each page-table page once and free everything still
+  // mapped, including pages of vmas above sz, in a single batch.
+  // The caller must already have unmapped the trampoline and the
+  // trapframe.
+  void *batch = 0;
+
+  freewalk_batch(pagetable, &batch);
+  kfreebatch(batch);
+  // - DEISO - P3
+}
+
+// + DEISO - P3
+// Recursively drop the user pages and page-table pages of
+// pagetable onto *batch.
+static void
+freewalk_batch(pagetable_t pagetable, void **batch)
 {
   // there are 2^9 = 512 PTEs in a page table.
   for(int i = 0; i < 512; i++){
     pte_t pte = pagetable[i];
-    if((pte & PTE_V) && (pte & (PTE_R|PTE_W|PTE_X)) == 0){
+    if((pte & PTE_V) == 0)
+      continue;
+    if((pte & (PTE_R|PTE_W|PTE_X)) == 0){
       // this PTE points to a lower-level page table.
-      uint64 child = PTE2PA(pte);
-      freewalk((pagetable_t)child);
-      pagetable[i] = 0;
-    } else if(pte & PTE_V){
-      panic("freewalk: leaf");
+      freewalk_batch((pagetable_t)PTE2PA(pte), batch);
+    } else {
+      kput(batch, (void *)PTE2PA(pte));
     }
   }
-  kfree((void*)pagetable);
-}
-
-// Free user memory pages,
-// then free page-table pages.
-void
-uvmfree(pagetable_t pagetable, uint64 sz)
-{
-  if(sz > 0)
-    uvmunmap(pagetable, 0, PGROUNDUP(sz)/PGSIZE, 1);
-  freewalk(pagetable);
+  kput(batch, (void *)pagetable);
 }
+// - DEISO - P3
 
 // Given a parent process's page table, copy
 // its memory into a child's page table.
@@ -338,7 +389,11 @@ uvmcopy(pagetable_t old, pagetable_t new, uint64 sz)
 
   for(i = 0; i < sz; i += PGSIZE){
     if((pte = walk(old, i, 0)) == 0)
-      panic("uvmcopy: pte should exist");
+      // + DEISO - P3
+      //panic("uvmcopy: pte should exist");
+      // The stack reserve below the user stack may lack page-table pages.
+      continue;
+      // - DEISO - P3
     if((*pte & PTE_V) == 0)
       // + DEISO - P2
       //panic("uvmcopy: page not present");
@@ -358,6 +413,10 @@ uvmcopy(pagetable_t old, pagetable_t new, uint64 sz)
     }
     // - DEISO - P2
   }
+  // + DEISO - P3
+  // The parent's writable pages just became copy-on-write.
+  uvmflush(old);
+  // - DEISO - P3
   return 0;
 
  err:
@@ -384,31 +443,29 @@ uvmclear(pagetable_t pagetable, uint64 va)
 int
 copyout(pagetable_t pagetable, uint64 dstva, char *src, uint64 len)
 {
-  uint64 n, va0, pa0;
-  pte_t *pte;
+  uint64 n;
+  char *dst;
+  // + DEISO - P3
+  pte_t *pte = 0;
+
+#ifdef UACCESS_SUM
+  if(uaccess_ok(pagetable, dstva, len)){
+    if(uaccess_copy((char *)(USERALIAS + dstva), src, len) == 0)
+      return 0;
+    // It faulted: the walk below faults pages in or breaks
+    // copy-on-write as needed and redoes the whole copy.
+  }
+#endif
+
   while(len > 0){
-    va0 = PGROUNDDOWN(dstva);
-    if(va0 >= MAXVA)
-      return -1;
-    // + DEISO - P2
-    // Allocate the page on the user if missing or check for copy on write.
-    if (walkaddr(pagetable, va0) == 0 ||copy_on_write(pagetable, va0) < 0) {
-      return -1;
-    }
-    // - DEISO - P2
-    pte = walk(pagetable, va0, 0);
-    if(pte == 0 || (*pte & PTE_V) == 0 || (*pte & PTE_U) == 0 ||
-       (*pte & PTE_W) == 0)
+    if((dst = uvmrange(pagetable, dstva, len, 1, &pte, &n)) == 0)
       return -1;
-    pa0 = PTE2PA(*pte);
-    n = PGSIZE - (dstva - va0);
-    if(n > len)
-      n = len;
-    memmove((void *)(pa0 + (dstva - va0)), src, n);
+    memmove(dst, src, n);
+  // - DEISO - P3
 
     len -= n;
     src += n;
-    dstva = va0 + PGSIZE;
+    dstva += n;
   }
   return 0;
 }
@@ -419,21 +476,27 @@ copyout(pagetable_t pagetable, uint64 dstva, char *src, uint64 len)
 int
 copyin(pagetable_t pagetable, char *dst, uint64 srcva, uint64 len)
 {
-  uint64 n, va0, pa0;
+  uint64 n;
+  char *src;
+  // + DEISO - P3
+  pte_t *pte = 0;
+
+#ifdef UACCESS_SUM
+  if(uaccess_ok(pagetable, srcva, len)){
+    if(uaccess_copy(dst, (char *)(USERALIAS + srcva), len) == 0)
+      return 0;
+  }
+#endif
 
   while(len > 0){
-    va0 = PGROUNDDOWN(srcva);
-    pa0 = walkaddr(pagetable, va0);
-    if(pa0 == 0)
+    if((src = uvmrange(pagetable, srcva, len, 0, &pte, &n)) == 0)
       return -1;
-    n = PGSIZE - (srcva - va0);
-    if(n > len)
-      n = len;
-    memmove(dst, (void *)(pa0 + (srcva - va0)), n);
+    memmove(dst, src, n);
+  // - DEISO - P3
 
     len -= n;
     dst += n;
-    srcva = va0 + PGSIZE;
+    srcva += n;
   }
   return 0;
 }
@@ -445,19 +508,37 @@ copyin(pagetable_t pagetable, char *dst, uint64 srcva, uint64 len)
 int
 copyinstr(pagetable_t pagetable, char *dst, uint64 srcva, uint64 max)
 {
-  uint64 n, va0, pa0;
+  uint64 n, va0;
   int got_null = 0;
+  // + DEISO - P3
+  pte_t *pte = 0;
+
+#ifdef UACCESS_SUM
+  if(uaccess_ok(pagetable, srcva, 0)){
+    // The string may not run into the trapframes.
+    n = max < USERTOP - srcva ? max : USERTOP - srcva;
+    switch(uaccess_copystr(dst, (char *)(USERALIAS + srcva), n)){
+    case 0:
+      return 0;
+    case 1:
+      return -1;
+    }
+  }
+#endif
 
   while(got_null == 0 && max > 0){
     va0 = PGROUNDDOWN(srcva);
-    pa0 = walkaddr(pagetable, va0);
-    if(pa0 == 0)
+    // Strings are short, so step page by page rather than
+    // asking uvmrange() for a run that may fault in pages
+    // past the terminating nul.
+    if((pte = uvmstep(pagetable, pte, va0, 0)) == 0)
       return -1;
     n = PGSIZE - (srcva - va0);
     if(n > max)
       n = max;
 
-    char *p = (char *) (pa0 + (srcva - va0));
+    char *p = (char *) (PTE2PA(*pte) + (srcva - va0));
+  // - DEISO - P3
     while(n > 0){
       if(*p == '\0'){
         *dst = '\0';
@@ -496,53 +577,299 @@ int copy_on_write(pagetable_t p, uint64 addr) {
     pte = walk(p, addr, 0);
   }
 
-  // Check if pte is copy on write
-  if (!(*pte & PTE_COW)) {
+  // + DEISO - P3
+  return cowpte(p, pte);
+  // - DEISO - P3
+}
+// - DEISO - P2
+
+// + DEISO - P3
+// Break copy-on-write for the page mapped by pte. The page is
+// copied if someone else still references it, otherwise it is
+// just made writable again. Shared mappings are always made
+// writable in place. Returns 1 if the pte was copy-on-write,
+// 0 if it was not and -1 if a copy could not be allocated.
+static int
+cowpte(pagetable_t pagetable, pte_t *pte)
+{
+  uint64 pa;
+  uint flags;
+  char *mem;
+
+  if((*pte & PTE_COW) == 0)
     return 0;
-  }
-  
-  // Shared pages with copy on write must not be copied.
-  if (*pte & PTE_COW && *pte & PTE_SHARED) {
-    return 1;
-  }
 
-  // Get the original page and references.
-  uint64 pa = PTE2PA(*pte);
-  uint num_ref = getref((void *)pa);
- 
-  // If there are multiple references to the page create a copy.
-  if (num_ref > 1) {
-    // Aloc memory.
-    char *mem = kalloc();
-    if (mem == 0) {
+  flags = (PTE_FLAGS(*pte) | PTE_W) & ~PTE_COW;
+  pa = PTE2PA(*pte);
+
+  if((*pte & PTE_SHARED) == 0 && getref((void *)pa) > 1){
+    if((mem = kalloc()) == 0)
       return -1;
-    }
-    
-    // Copy original content to new page.
     memmove(mem, (char *)pa, PGSIZE);
-    
-    // Get pte flags, disable copy on write and enable write permission.
-    uint flags = PTE_FLAGS(*pte);
-    flags |= PTE_W;
-    flags &= ~(PTE_COW);
-    
-    // Remap to the address provided the new allocated page.
-    uvmunmap(p, addr, 1, 1);
-    if (mappages(p, addr, PGSIZE, (uint64)mem, flags) < 0)
-	{
-		kfree(mem);
-		return -1;
-	}
-	
+    *pte = PA2PTE(mem) | flags;
+    // Drop our reference to the original page, once our other
+    // threads no longer read it instead of the copy.
+    tlbput(pagetable, (void *)pa);
+    myproc()->mstat.cowcopy++;
     return 1;
   }
-  // If there is only one reference remaining only change flags.
-  else if (num_ref == 1) {
-    *pte |= PTE_W;
-    *pte &= ~(PTE_COW);
-    return 1;
+
+  *pte = PA2PTE(pa) | flags;
+  myproc()->mstat.cowreuse++;
+  return 1;
+}
+
+// Translate the user virtual address va for a kernel access with
+// a single page-table walk. Pages of a VMA that are yet to be
+// mapped are faulted in and, if write is set, copy-on-write is
+// broken on the spot. Returns the leaf pte, or 0 if the kernel
+// may not access va on behalf of the user.
+static pte_t *
+uvmaccess(pagetable_t pagetable, uint64 va, int write)
+{
+  struct proc *p = myproc();
+  pte_t *pte;
+  int locked = 0, spin;
+
+  if(va >= MAXVA)
+    return 0;
+
+  pte = walk(pagetable, va, 0);
+  if(pte == 0 || (*pte & PTE_V) == 0 || (write && (*pte & PTE_W) == 0)){
+    // About to change mappings our threads share; one of them
+    // may have changed them already.
+    if(p->pagetable == pagetable){
+      locked = vmlock(p);
+      // Holding spinlocks, we could race with a thread that holds
+      // mmlock, and could not wait for the shootdown of a page we
+      // take away: leave it to the caller to uvmprefault() the
+      // page without its spinlocks and try again.
+      if(!locked && p->vs->users > 1){
+        push_off();
+        spin = mycpu()->noff > 1;
+        pop_off();
+        if(spin)
+          return 0;
+      }
+    }
+    pte = walk(pagetable, va, 0);
+  }
+  if(pte == 0 || (*pte & PTE_V) == 0){
+    if(alloc_vma(p->mm, pagetable, va) < 0){
+      pte = 0;
+      goto out;
+    }
+    pte = walk(pagetable, va, 0);
+    uvmflush(pagetable);
+  }
+  if((*pte & PTE_U) == 0){
+    pte = 0;
+    goto out;
+  }
+  if(write && (*pte & PTE_W) == 0){
+    if(cowpte(pagetable, pte) <= 0){
+      pte = 0;
+      goto out;
+    }
+    uvmflush(pagetable);
+  }
+out:
+  if(locked)
+    vmunlock(p);
+  return pte;
+}
+
+// Like uvmaccess(), for the page va that follows the one mapped by
+// prev. While both pages share a page-table page the pte is found
+// by stepping to the next slot instead of walking from the root.
+static pte_t *
+uvmstep(pagetable_t pagetable, pte_t *prev, uint64 va, int write)
+{
+  pte_t *pte;
+
+  if(prev != 0 && PX(0, va) != 0){
+    pte = prev + 1;
+    if((*pte & (PTE_V | PTE_U)) == (PTE_V | PTE_U) &&
+       (write == 0 || (*pte & PTE_W)))
+      return pte;
+  }
+  return uvmaccess(pagetable, va, write);
+}
+
+// Find where the kernel can reach the user range [va, va+len).
+// Returns the kernel address of va and sets *n to how many of the
+// len bytes that follow are physically contiguous, so the caller
+// can move them with a single memmove. *pte must be 0 on the first
+// call and carries the last pte used from one call to the next.
+// Returns 0 if va is not accessible.
+static char *
+uvmrange(pagetable_t pagetable, uint64 va, uint64 len, int write,
+         pte_t **pte, uint64 *n)
+{
+  uint64 va0, m;
+  pte_t *p, *q;
+  char *start;
+
+  va0 = PGROUNDDOWN(va);
+  if((p = uvmstep(pagetable, *pte, va0, write)) == 0)
+    return 0;
+  start = (char *)(PTE2PA(*p) + (va - va0));
+
+  m = PGSIZE - (va - va0);
+  while(m < len){
+    q = uvmstep(pagetable, p, va0 + PGSIZE, write);
+    if(q == 0 || PTE2PA(*q) != PTE2PA(*p) + PGSIZE)
+      break;
+    p = q;
+    va0 += PGSIZE;
+    m += PGSIZE;
+  }
+  if(m > len)
+    m = len;
+
+  *pte = p;
+  *n = m;
+  return start;
+}
+// - DEISO - P3
+
+// + DEISO - P3
+// Fault in the user pages of [va, va+len) and, if write is set,
+// break copy-on-write on them, for a caller whose copy failed
+// because it held spinlocks (see uvmaccess()). Must be called
+// without spinlocks. Returns -1 if some page is not accessible.
+int
+uvmprefault(pagetable_t pagetable, uint64 va, uint64 len, int write)
+{
+  uint64 a;
+
+  for(a = PGROUNDDOWN(va); a < va + len; a += PGSIZE)
+    if(uvmaccess(pagetable, a, write) == 0)
+      return -1;
+  return 0;
+}
+
+// The physical address behind the user address va, which must
+// be writable, and in *shared whether va is in a MAP_SHARED
+// mapping: futex() keys sleepers on such pages by it.
+// Copy-on-write is broken first. Returns 0 if va is not
+// accessible.
+uint64
+uvmphys(pagetable_t pagetable, uint64 va, int *shared)
+{
+  pte_t *pte;
+
+  if((pte = uvmaccess(pagetable, PGROUNDDOWN(va), 1)) == 0)
+    return 0;
+  *shared = (*pte & PTE_SHARED) != 0;
+  return PTE2PA(*pte) + (va - PGROUNDDOWN(va));
+}
+
+// Load the int at the aligned user address va through whatever
+// page maps it now, without faulting anything in, so it can be
+// done with spinlocks held. Returns -1 if va is not mapped.
+int
+uvmload(pagetable_t pagetable, uint64 va, int *val)
+{
+  pte_t *pte;
+
+  if(va >= MAXVA || (pte = walk(pagetable, va, 0)) == 0 ||
+     (*pte & (PTE_V | PTE_U)) != (PTE_V | PTE_U))
+    return -1;
+  *val = __atomic_load_n((int *)(PTE2PA(*pte) + (va - PGROUNDDOWN(va))),
+                         __ATOMIC_SEQ_CST);
+  return 0;
+}
+// - DEISO - P3
+
+// + DEISO - P3
+// Make the user space of pagetable, which is about to run on this
+// hart, visible at USERALIAS in the hart's kernel page table, by
+// sharing its lower-half root entries. Only UACCESS_SUM kernels
+// keep such an alias.
+void
+uvmswitch(pagetable_t pagetable)
+{
+#ifdef UACCESS_SUM
+  pagetable_t kpgtbl = mycpu()->kpagetable;
+
+  memmove(&kpgtbl[PX(2, USERALIAS)], pagetable, PGSIZE / 2);
+  sfence_vma();
+#endif
+}
+
+// The kernel changed pagetable. If it belongs to the process on
+// this hart, bring the hart's alias of it up to date and drop any
+// stale translations the copy routines may have left in the TLB.
+void
+uvmflush(pagetable_t pagetable)
+{
+#ifdef UACCESS_SUM
+  struct proc *p = myproc();
+
+  if(p != 0 && p->pagetable == pagetable){
+    push_off();
+    uvmswitch(pagetable);
+    pop_off();
+  }
+#endif
+}
+
+#ifdef UACCESS_SUM
+// Can [va, va+len) of pagetable be reached through USERALIAS?
+// Only the running process's own memory below the trapframes
+// (USERTOP) is aliased; anything else goes through the page-table
+// walk.
+static int
+uaccess_ok(pagetable_t pagetable, uint64 va, uint64 len)
+{
+  struct proc *p = myproc();
+
+  if(p == 0 || p->pagetable != pagetable)
+    return 0;
+  return va < USERTOP && len <= USERTOP - va;
+}
+#endif
+
+struct exentry {
+  uint64 insn;
+  uint64 fixup;
+};
+
+extern struct exentry __ex_table_start[], __ex_table_end[];
+
+// Return where kerneltrap() should resume after a page fault at
+// kernel pc epc, or 0 if epc is not a user access in uaccess.S.
+uint64
+uaccess_fixup(uint64 epc)
+{
+  struct exentry *e;
+
+  for(e = __ex_table_start; e < __ex_table_end; e++)
+    if(e->insn == epc)
+      return e->fixup;
+  return 0;
+}
+// - DEISO - P3
+
+// + DEISO - P3
+// Count the user pages mapped in pagetable, and how many of them
+// are shared with another process, for getmstat().
+void
+uvmcount(pagetable_t pagetable, int level, uint64 *rss, uint64 *shared)
+{
+  for(int i = 0; i < 512; i++){
+    pte_t pte = pagetable[i];
+    if((pte & PTE_V) == 0)
+      continue;
+    if((pte & (PTE_R|PTE_W|PTE_X)) == 0){
+      if(level > 0)
+        uvmcount((pagetable_t)PTE2PA(pte), level - 1, rss, shared);
+    } else if(pte & PTE_U){
+      (*rss)++;
+      if((pte & PTE_SHARED) || getref((void *)PTE2PA(pte)) > 1)
+        (*shared)++;
+    }
   }
-  // Zero page references is impossible.
-  else return -1;
 }
-// - DEISO - P2
\ No newline at end of file
+// - DEISO - P3
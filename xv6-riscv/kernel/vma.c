@@ -51,7 +51,7 @@ uint64 *create_vma_program(struct mm *mm, uint64 addr, uint64 len, struct inode
     return (uint64 *)vma->start;
 }
 
-uint64 *create_vma_stack(struct mm *mm, uint64 addr, uint64 len, int prot, int flags) {
+uint64 *create_vma_stack(struct mm *mm, uint64 addr, uint64 len, uint64 len_limit, int prot, int flags) {
 
     struct vma *vma = 0;
     for (int i = 0; i < MAX_VMA; ++i) 
@@ -73,7 +73,10 @@ uint64 *create_vma_stack(struct mm *mm, uint64 addr, uint64 len, int prot, int f
     vma->file = 0;
     vma->ip = 0;
     vma->len = len;
-    vma->len_limit = len;
+    // + DEISO - P3
+    // For stacks, the size the vma may grow to.
+    vma->len_limit = len_limit;
+    // - DEISO - P3
     vma->off = 0;
     vma->prot = prot;
     vma->flags = flags;
@@ -105,7 +108,9 @@ uint64 *create_vma_file(struct mm *mm, uint64 len, struct file *f, uint64 off, i
     if (vma == 0) return (uint64 *) -1;
 
     struct vma *cur = mm->first_vma;
-    uint64 start = PGROUNDDOWN(TRAPFRAME - len);
+    // + DEISO - P3
+    uint64 start = PGROUNDDOWN(USERTOP - len);
+    // - DEISO - P3
     if (cur != 0) {
         while (cur->next != 0) { 
             cur = cur->next;
@@ -137,9 +142,39 @@ uint64 *create_vma_file(struct mm *mm, uint64 len, struct file *f, uint64 off, i
     return (uint64 *) vma->start;
 }
 
+// + DEISO - P3
+// Grow a STACK vma down to cover addr if addr lies below it, but
+// no further than len_limit below its top.
+static struct vma *grow_vma_stack(struct mm *mm, uint64 addr) {
+
+    for (int i = 0; i < MAX_VMA; i++) {
+        struct vma *vma = &mm->vmas[i];
+        if (vma->type != STACK) continue;
+        uint64 top = vma->start + vma->len;
+        if (addr < vma->start && addr >= top - vma->len_limit) {
+            uint64 start = PGROUNDDOWN(addr);
+            vma->len += vma->start - start;
+            vma->start = start;
+            return vma;
+        }
+    }
+    return (struct vma *)-1;
+}
+// - DEISO - P3
+
 int alloc_vma(struct mm *mm, pagetable_t pagetable, uint64 addr) {
 
+    // + DEISO - P3
+    // Another thread may have faulted the page in first.
+    if (addr >= MAXVA) return -1;
+    pte_t *pte = walk(pagetable, PGROUNDDOWN(addr), 0);
+    if (pte != 0 && (*pte & PTE_V) != 0) return 0;
+    // - DEISO - P3
+
     struct vma *vma = find_vma(mm, addr);
+    // + DEISO - P3
+    if (vma == (struct vma *)-1) vma = grow_vma_stack(mm, addr);
+    // - DEISO - P3
     if (vma == (struct vma *)-1) return -1;
 
     if (vma->type == NONE) return -1;
@@ -159,12 +194,22 @@ int alloc_vma(struct mm *mm, pagetable_t pagetable, uint64 addr) {
         return -1;
     }
 
-    if (vma->type == STACK) return 0;
+    // + DEISO - P3
+    struct proc *p = myproc();
+    // - DEISO - P3
+
+    if (vma->type == STACK) {
+        p->mstat.minflt++;
+        return 0;
+    }
 
     uint64 page_count_bytes = PGROUNDDOWN(addr - vma->start);
     uint64 offset = page_count_bytes + vma->off;
     // Edge case where where it will try to read after the end if addr is big enough.
-    if (vma->len_limit < page_count_bytes) return 0;
+    if (vma->len_limit < page_count_bytes) {
+        p->mstat.minflt++;
+        return 0;
+    }
     uint64 rem = vma->len_limit - page_count_bytes;
     uint64 n = PGSIZE >= rem ? rem : PGSIZE;
     if (offset + n > vma->ip->size) n = vma->ip->size - offset;
@@ -176,10 +221,40 @@ int alloc_vma(struct mm *mm, pagetable_t pagetable, uint64 addr) {
         return -1;
     };
     iunlock(vma->ip);
+    p->mstat.majflt++;
 
     return 0;
 }
 
+// + DEISO - P3
+// Drop the references a vma holds and return its slot to mm,
+// without touching the pages it maps.
+static void release_vma(struct mm *mm, struct vma *vma) {
+
+    if (vma->type == FILE) fileclose(vma->file);
+    if (vma->type == PROGRAM) {
+        begin_op();
+        iput(vma->ip);
+        end_op();
+    }
+    if (vma->prev != 0) vma->prev->next = vma->next;
+    if (vma->next != 0) vma->next->prev = vma->prev;
+    if (mm->first_vma == vma) mm->first_vma = vma->next;
+
+    vma->start = 0;
+    vma->len = 0;
+    vma->type = NONE;
+    vma->off = 0;
+    vma->file = 0;
+    vma->len_limit = 0;
+    vma->ip = 0;
+    vma->prot = 0;
+    vma->flags = 0;
+    vma->next = 0;
+    vma->prev = 0;
+}
+// - DEISO - P3
+
 int delete_vma(struct mm *mm, pagetable_t pagetable, uint64 addr, uint64 len) {
     
     struct vma *vma = find_vma(mm, addr);
@@ -192,9 +267,15 @@ int delete_vma(struct mm *mm, pagetable_t pagetable, uint64 addr, uint64 len) {
     uint64 a = addr;
     uint64 npages = PGROUNDUP(len) / PGSIZE;
     pte_t *pte = 0;
+    // + DEISO - P3
+    void *batch = 0;
+    // - DEISO - P3
     for (a = addr; a < addr + npages * PGSIZE; a += PGSIZE)
     {
-        if ((pte = walk(pagetable, a, 0)) == 0) panic("delete_mapping: walk");
+        // + DEISO - P3
+        // Parts of a demand-paged vma may never have been touched.
+        if ((pte = walk(pagetable, a, 0)) == 0) continue;
+        // - DEISO - P3
         if (PTE_FLAGS(*pte) == PTE_V) panic("delete_mapping: not a leaf");
         if ((*pte & PTE_V) != 0)
         {
@@ -227,32 +308,28 @@ int delete_vma(struct mm *mm, pagetable_t pagetable, uint64 addr, uint64 len) {
                     if (r != n1) break;
                     i += r;
                 }
+                // + DEISO - P3
+                myproc()->mstat.writeback++;
+                // - DEISO - P3
             }
-            if (getref((void *)pa) == 1) kfree((void *)pa);
-            else decref((void *)pa);
+            // + DEISO - P3
+            kput(&batch, (void *)pa);
+            // - DEISO - P3
         }
         *pte = 0;
     }
+    // + DEISO - P3
+    uvmflush(pagetable);
+    if (batch && tlbshootdown(pagetable) == 0)
+        panic("delete_vma: shootdown");
+    kfreebatch(batch);
+    // - DEISO - P3
 
     if (addr == vma->start && len == vma->len)
     {
-        if (vma->type == FILE) fileclose(vma->file);
-        if (vma->type == PROGRAM) iput(vma->ip);
-        if (vma->prev != 0) vma->prev->next = vma->next;
-        if (vma->next != 0) vma->next->prev = vma->prev;
-        if (mm->first_vma == vma) mm->first_vma = vma->next;
-
-        vma->start = 0;
-        vma->len = 0;
-        vma->type = NONE;
-        vma->off = 0;
-        vma->file = 0;
-        vma->len_limit = 0;
-        vma->ip = 0;
-        vma->prot = 0;
-        vma->flags = 0;
-        vma->next = 0;
-        vma->prev = 0;
+        // + DEISO - P3
+        release_vma(mm, vma);
+        // - DEISO - P3
     }
     else if (addr == vma->start)
     {
@@ -303,7 +380,16 @@ void mm_destroy(struct mm *mm, pagetable_t pagetable)
         if (mm->vmas[i].type != NONE)
         {
             struct vma *vma = &mm->vmas[i];
-            delete_vma(mm, pagetable, vma->start, vma->len);
+            // + DEISO - P3
+            // Only shared, writable file mappings need the page by
+            // page walk, to write dirty pages back. The pages of the
+            // rest are freed in one batch when the caller tears the
+            // page table down with proc_freepagetable().
+            if (vma->type == FILE && vma->flags & MAP_SHARED && vma->prot & PROT_WRITE)
+                delete_vma(mm, pagetable, vma->start, vma->len);
+            else
+                release_vma(mm, vma);
+            // - DEISO - P3
         }
     }
     mm->first_vma = 0;
@@ -325,7 +411,7 @@ void mm_copy(struct mm *src, struct mm *dst)
                 create_vma_file(dst, cur->len, cur->file, cur->off, cur->prot, cur->flags);
                 break;
             case STACK:
-                create_vma_stack(dst, cur->start, cur->len, cur->prot, cur->flags);
+                create_vma_stack(dst, cur->start, cur->len, cur->len_limit, cur->prot, cur->flags);
                 break;
             default:
                 break;
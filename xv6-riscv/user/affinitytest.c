@@ -0,0 +1,122 @@
+//
+// test setaffinity() and the migration counters in getpinfo().
+// finds the running harts by pinning itself to each in turn,
+// checking that it then runs there. then runs two CPU-bound
+// spinners per hart for a while, unpinned, and reports how
+// often they moved between harts, and once more with each
+// pinned to a hart of its own choosing, when they must stay
+// put.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/pstat.h"
+#include "user/user.h"
+
+#define TICKS 100    // length of each measurement
+
+int pids[2 * NCPU];
+int migs[2 * NCPU];
+struct pstat st;
+
+void
+fail(char *why)
+{
+  printf("affinitytest: FAIL, %s\n", why);
+  exit(1);
+}
+
+// slot of pid in st, or -1.
+int
+slotof(int pid)
+{
+  for(int i = 0; i < NPROC; i++)
+    if(st.inuse[i] && st.pid[i] == pid)
+      return i;
+  return -1;
+}
+
+void
+spin(void)
+{
+  volatile int x = 0;
+
+  for(;;)
+    x++;
+}
+
+// total migrations of the n spinners since the last call.
+int
+migrations(int n)
+{
+  int total = 0;
+
+  getpinfo(&st);
+  for(int i = 0; i < n; i++){
+    int s = slotof(pids[i]);
+    if(s < 0)
+      fail("spinner gone");
+    total += st.nmigrate[s] - migs[i];
+    migs[i] = st.nmigrate[s];
+  }
+  return total;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int harts[NCPU], nharts = 0, n, m;
+
+  for(int i = 0; i < NCPU; i++){
+    if(setaffinity(0, 1UL << i) < 0)
+      continue;
+    getpinfo(&st);
+    if(st.cpu[slotof(getpid())] != i)
+      fail("not moved to the hart pinned to");
+    harts[nharts++] = i;
+  }
+  if(nharts == 0)
+    fail("no hart accepted");
+  if(setaffinity(0, 0) != -1)
+    fail("empty mask accepted");
+  setaffinity(0, ~0UL);
+  printf("affinitytest: %d harts online\n", nharts);
+
+  n = 2 * nharts;
+  for(int i = 0; i < n; i++){
+    if((pids[i] = fork()) < 0)
+      fail("fork");
+    if(pids[i] == 0)
+      spin();
+  }
+
+  migrations(n);
+  sleep(TICKS);
+  m = migrations(n);
+  printf("affinitytest: %d spinners unpinned: %d migrations in %d ticks\n",
+         n, m, TICKS);
+
+  for(int i = 0; i < n; i++)
+    if(setaffinity(pids[i], 1UL << harts[i % nharts]) < 0)
+      fail("setaffinity of a child");
+  // let each get to its hart once.
+  sleep(10);
+  migrations(n);
+  sleep(TICKS);
+  m = migrations(n);
+  printf("affinitytest: %d spinners pinned: %d migrations in %d ticks\n",
+         n, m, TICKS);
+  for(int i = 0; i < n; i++)
+    if(st.cpu[slotof(pids[i])] != harts[i % nharts])
+      fail("a pinned spinner ran elsewhere");
+  if(m != 0)
+    fail("pinned spinners migrated");
+
+  for(int i = 0; i < n; i++){
+    kill(pids[i]);
+    wait(0);
+  }
+  printf("affinitytest: OK\n");
+  exit(0);
+}
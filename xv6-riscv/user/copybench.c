@@ -0,0 +1,143 @@
+//
+// benchmark for the kernel's user copy routines
+// (copyin/copyout/copyinstr in kernel/vm.c).
+// times large read() and write() system calls on a file
+// small enough to stay in the buffer cache, and reports
+// how many KB each path moves per clock tick.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/fcntl.h"
+#include "kernel/riscv.h"
+#include "user/user.h"
+
+#define FILESZ  (16*1024)   // fits in the buffer cache (NBUF blocks)
+#define ROUNDS  2000
+#define NOPEN   20000
+
+char *file = "copybench.tmp";
+char *buf;
+
+// report a result as KB moved per tick.
+void
+report(char *what, uint64 bytes, int t)
+{
+  if(t == 0)
+    t = 1;
+  printf("copybench: %s: %lu KB in %d ticks, %lu KB/tick\n",
+         what, bytes / 1024, t, bytes / 1024 / t);
+}
+
+void
+mkfile(void)
+{
+  int fd;
+
+  if((fd = open(file, O_CREATE | O_RDWR | O_TRUNC)) < 0){
+    printf("copybench: cannot create %s\n", file);
+    exit(1);
+  }
+  if(write(fd, buf, FILESZ) != FILESZ){
+    printf("copybench: write failed\n");
+    exit(1);
+  }
+  close(fd);
+}
+
+// read() the whole file into buf ROUNDS times: copyout().
+void
+readtest(char *what)
+{
+  int fd, t0, i;
+
+  t0 = uptime();
+  for(i = 0; i < ROUNDS; i++){
+    if((fd = open(file, O_RDONLY)) < 0){
+      printf("copybench: cannot open %s\n", file);
+      exit(1);
+    }
+    if(read(fd, buf, FILESZ) != FILESZ){
+      printf("copybench: short read\n");
+      exit(1);
+    }
+    close(fd);
+  }
+  report(what, (uint64)ROUNDS * FILESZ, uptime() - t0);
+}
+
+// write() buf over the file ROUNDS/10 times: copyin().
+// this also pays for the log, so expect fewer KB/tick.
+void
+writetest(void)
+{
+  int fd, t0, i;
+
+  t0 = uptime();
+  for(i = 0; i < ROUNDS / 10; i++){
+    if((fd = open(file, O_WRONLY)) < 0){
+      printf("copybench: cannot open %s\n", file);
+      exit(1);
+    }
+    if(write(fd, buf, FILESZ) != FILESZ){
+      printf("copybench: short write\n");
+      exit(1);
+    }
+    close(fd);
+  }
+  report("write", (uint64)(ROUNDS / 10) * FILESZ, uptime() - t0);
+}
+
+// open() a missing file with a long path: copyinstr().
+void
+pathtest(void)
+{
+  char path[MAXPATH];
+  int t0, i;
+
+  memset(path, 'x', sizeof(path) - 1);
+  path[sizeof(path) - 1] = 0;
+  t0 = uptime();
+  for(i = 0; i < NOPEN; i++)
+    open(path, O_RDONLY);
+  report("copyinstr", (uint64)NOPEN * sizeof(path), uptime() - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int pid;
+
+  // buf spans several pages, so each read()/write() crosses
+  // page boundaries.
+  buf = sbrk(FILESZ + PGSIZE);
+  if(buf == (char *)-1){
+    printf("copybench: sbrk failed\n");
+    exit(1);
+  }
+  buf = (char *)PGROUNDUP((uint64)buf);
+  memset(buf, 'a', FILESZ);
+
+  mkfile();
+  readtest("read");
+  writetest();
+  pathtest();
+
+  // in a fork()ed child every page of buf starts out
+  // copy-on-write, so the first read() breaks COW from
+  // inside copyout().
+  pid = fork();
+  if(pid < 0){
+    printf("copybench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    readtest("read (cow child)");
+    exit(0);
+  }
+  wait(0);
+
+  unlink(file);
+  exit(0);
+}
@@ -0,0 +1,96 @@
+//
+// benchmark for fork(), exit() and wait().
+// forks and reaps short-lived children as fast as it can for
+// TICKS ticks, while a number of long-lived siblings sit
+// asleep on a pipe, and reports the forks per tick. wait()
+// only looks at the caller's own exited children, so the
+// rate should not drop as the siblings fill the table;
+// rebuild with make NPROC=n for a bigger table.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+#define TICKS 50    // length of each measurement
+
+// fork n children that block reading fd until it is closed.
+void
+fill(int n, int fd)
+{
+  char c;
+
+  for(int i = 0; i < n; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf("forkbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      read(fd, &c, 1);
+      exit(0);
+    }
+  }
+}
+
+void
+run(int nfill)
+{
+  int p[2], n, t0;
+
+  if(pipe(p) < 0){
+    printf("forkbench: pipe failed\n");
+    exit(1);
+  }
+  fill(nfill, p[0]);
+  close(p[0]);
+
+  n = 0;
+  t0 = uptime();
+  while(uptime() - t0 < TICKS){
+    int pid = fork();
+    if(pid < 0){
+      printf("forkbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0)
+      exit(0);
+    if(wait(0) != pid){
+      printf("forkbench: wait returned the wrong child\n");
+      exit(1);
+    }
+    n++;
+  }
+  printf("forkbench: NPROC %d, %d siblings: %d forks/tick\n",
+         NPROC, nfill, n / TICKS);
+
+  // let the siblings go.
+  close(p[1]);
+  for(int i = 0; i < nfill; i++)
+    if(wait(0) < 0){
+      printf("forkbench: wait stopped early\n");
+      exit(1);
+    }
+  if(wait(0) != -1){
+    printf("forkbench: wait got too many\n");
+    exit(1);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  // leave room for init, sh, ourselves and the forked child.
+  int max = NPROC - 8;
+
+  if(argc > 1){
+    run(atoi(argv[1]));
+    exit(0);
+  }
+  run(0);
+  run(max / 4);
+  run(max / 2);
+  run(max);
+  exit(0);
+}
@@ -0,0 +1,143 @@
+//
+// benchmark for futex() and the locks in user/mutex.c.
+// NWORK processes share a page through a MAP_SHARED mapping of
+// a file and take turns bumping a counter in it, LOOPS times
+// each: first under a spinlock that busy-waits, then under a
+// mutex that sleeps in futex() while it is taken. with more
+// workers than harts a spinning waiter burns the time the
+// holder needs to let go, so the mutex should finish sooner.
+// then the workers pass a token round a ring with a condition
+// variable. reports the ticks each run took, and checks that
+// no update was lost.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "user/user.h"
+
+#define NWORK  8       // workers
+#define LOOPS  20000   // lock round trips per worker
+#define ROUNDS 200     // trips of the token round the ring
+#define FILE   "futexbench.tmp"
+
+struct shared {
+  int spin;
+  struct mutex m;
+  struct cond c;
+  int count;
+  int turn;
+};
+
+struct shared *sh;
+char page[4096];
+
+void
+fail(char *why)
+{
+  printf("futexbench: %s\n", why);
+  unlink(FILE);
+  exit(1);
+}
+
+void
+spinworker(int i)
+{
+  for(int n = 0; n < LOOPS; n++){
+    while(__atomic_exchange_n(&sh->spin, 1, __ATOMIC_ACQUIRE))
+      ;
+    sh->count++;
+    __atomic_store_n(&sh->spin, 0, __ATOMIC_RELEASE);
+  }
+}
+
+void
+mutexworker(int i)
+{
+  for(int n = 0; n < LOOPS; n++){
+    mutex_lock(&sh->m);
+    sh->count++;
+    mutex_unlock(&sh->m);
+  }
+}
+
+// wait for the token, pass it on.
+void
+ringworker(int i)
+{
+  mutex_lock(&sh->m);
+  for(int n = 0; n < ROUNDS; n++){
+    while(sh->turn % NWORK != i)
+      cond_wait(&sh->c, &sh->m);
+    sh->turn++;
+    sh->count++;
+    cond_broadcast(&sh->c);
+  }
+  mutex_unlock(&sh->m);
+}
+
+// run worker in NWORK processes; returns the ticks they took.
+int
+run(void (*worker)(int))
+{
+  int t0 = uptime();
+
+  for(int i = 0; i < NWORK; i++){
+    int pid = fork();
+    if(pid < 0)
+      fail("fork failed");
+    if(pid == 0){
+      worker(i);
+      exit(0);
+    }
+  }
+  for(int i = 0; i < NWORK; i++)
+    wait(0);
+  return uptime() - t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, t;
+
+  // the shared page.
+  memset(page, 0, sizeof(page));
+  if((fd = open(FILE, O_CREATE | O_RDWR)) < 0)
+    fail("open failed");
+  if(write(fd, page, sizeof(page)) != sizeof(page))
+    fail("write failed");
+  sh = mmap(0, sizeof(page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(sh == (struct shared *)-1)
+    fail("mmap failed");
+  close(fd);
+  // fault it in now, so that the children share our page
+  // instead of each reading its own.
+  mutex_init(&sh->m);
+  cond_init(&sh->c);
+
+  sh->count = 0;
+  t = run(spinworker);
+  if(sh->count != NWORK * LOOPS)
+    fail("spinlock lost updates");
+  printf("futexbench: %d workers, spinlock: %d ticks\n", NWORK, t);
+
+  sh->count = 0;
+  t = run(mutexworker);
+  if(sh->count != NWORK * LOOPS)
+    fail("mutex lost updates");
+  printf("futexbench: %d workers, futex mutex: %d ticks\n", NWORK, t);
+
+  sh->count = 0;
+  sh->turn = 0;
+  t = run(ringworker);
+  if(sh->count != NWORK * ROUNDS)
+    fail("condition variable lost handoffs");
+  printf("futexbench: %d workers, condvar ring: %d handoffs in %d ticks\n",
+         NWORK, NWORK * ROUNDS, t);
+
+  munmap(sh, sizeof(page));
+  unlink(FILE);
+  printf("futexbench: OK\n");
+  exit(0);
+}
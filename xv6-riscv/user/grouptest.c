@@ -0,0 +1,105 @@
+//
+// test ticket groups (mkgroup(), getgstat()).
+// two groups are funded with the same number of tickets; one
+// runs FEW spinners, the other MANY. with groups, both should
+// get about the same CPU time even though the second has many
+// more processes. FEW is kept at least as large as the number
+// of harts, or the first group could not use its share.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/gstat.h"
+#include "user/user.h"
+
+#define FEW      4
+#define MANY     16
+#define FUNDING  100
+#define TICKS    300
+#define MAXERR   25    // allowed difference between the groups, percent
+
+int deadline;
+
+// burn CPU until the deadline, then exit.
+void
+spin(void)
+{
+  volatile int x = 0;
+
+  while(uptime() < deadline)
+    for(int i = 0; i < 100000; i++)
+      x++;
+}
+
+// fork a child that makes a group and runs n spinners in it.
+// returns the group id, which the child reports over a pipe.
+int
+group(int n)
+{
+  int fd[2], gid, pid;
+
+  if(pipe(fd) < 0){
+    printf("grouptest: pipe failed\n");
+    exit(1);
+  }
+  if((pid = fork()) < 0){
+    printf("grouptest: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    gid = mkgroup(FUNDING);
+    write(fd[1], &gid, sizeof(gid));
+    for(int i = 1; i < n; i++){
+      if(fork() == 0){
+        spin();
+        exit(0);
+      }
+    }
+    spin();
+    for(int i = 1; i < n; i++)
+      wait(0);
+    exit(0);
+  }
+  if(read(fd[0], &gid, sizeof(gid)) != sizeof(gid) || gid < 0){
+    printf("grouptest: mkgroup failed\n");
+    exit(1);
+  }
+  close(fd[0]);
+  close(fd[1]);
+  return gid;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct gstat a, b;
+  int ga, gb, err;
+
+  // the spinners stop on their own a little after we look.
+  deadline = uptime() + TICKS + 20;
+  ga = group(FEW);
+  gb = group(MANY);
+  sleep(TICKS);
+  if(getgstat(ga, &a) < 0 || getgstat(gb, &b) < 0){
+    printf("grouptest: getgstat failed\n");
+    exit(1);
+  }
+  wait(0);
+  wait(0);
+
+  printf("grouptest: group %d, %d members: %lu ticks\n", ga, a.members, a.ticks);
+  printf("grouptest: group %d, %d members: %lu ticks\n", gb, b.members, b.ticks);
+  if(a.ticks + b.ticks == 0){
+    printf("grouptest: no ticks recorded\n");
+    exit(1);
+  }
+  err = (int)(a.ticks > b.ticks ? a.ticks - b.ticks : b.ticks - a.ticks)
+        * 100 / (int)((a.ticks + b.ticks) / 2);
+  if(err > MAXERR){
+    printf("grouptest: FAIL, groups %d%% apart\n", err);
+    exit(1);
+  }
+  printf("grouptest: OK\n");
+  exit(0);
+}
@@ -0,0 +1,101 @@
+//
+// benchmark for waking a process on another hart.
+// two processes bounce a byte over a pair of pipes for
+// TICKS ticks, first both pinned to hart 0, then pinned to
+// harts 0 and 1, and finally free to run anywhere, and
+// reports the round trips and the microseconds each took.
+// between harts, every trip wakes a hart idle in wfi twice,
+// so it shows how long an idle hart takes to notice a
+// wakeup: without an IPI it waits for its next tick. run
+// with make CPUS=4, and again with make IPI=1 CPUS=4 to
+// compare.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+#define TICKS 100    // length of each measurement
+#define USPERTICK ((uint64)QUANTUM * 1000000 / TIMEBASE)
+
+// count round trips between this process, on the harts in
+// mine, and a child on the harts in its, for TICKS ticks.
+// returns -1 if either set has no running hart.
+int
+pingpong(uint64 mine, uint64 its)
+{
+  int ping[2], pong[2], ready[2];
+  int n, t0, pid;
+  char c = 0;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0 || pipe(ready) < 0){
+    printf("ipibench: pipe failed\n");
+    exit(1);
+  }
+  pid = fork();
+  if(pid < 0){
+    printf("ipibench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    close(ping[1]);
+    close(pong[0]);
+    close(ready[0]);
+    c = setaffinity(0, its) == 0;
+    write(ready[1], &c, 1);
+    close(ready[1]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit(0);
+  }
+  close(ping[0]);
+  close(pong[1]);
+  close(ready[1]);
+
+  n = -1;
+  if(read(ready[0], &c, 1) == 1 && c && setaffinity(0, mine) == 0){
+    n = 0;
+    t0 = uptime();
+    while(uptime() - t0 < TICKS){
+      write(ping[1], &c, 1);
+      if(read(pong[0], &c, 1) != 1){
+        printf("ipibench: short read\n");
+        exit(1);
+      }
+      n++;
+    }
+  }
+  close(ready[0]);
+  close(ping[1]);
+  close(pong[0]);
+  wait(0);
+  setaffinity(0, ~0UL);
+  return n;
+}
+
+void
+run(char *what, uint64 mine, uint64 its)
+{
+  int n = pingpong(mine, its);
+
+  if(n < 0){
+    printf("ipibench: %s: not enough harts, run with make CPUS=4\n", what);
+    return;
+  }
+  if(n == 0){
+    printf("ipibench: %s: no round trips\n", what);
+    return;
+  }
+  printf("ipibench: %s: %d round trips, %lu us each\n",
+         what, n, TICKS * USPERTICK / n);
+}
+
+int
+main(int argc, char *argv[])
+{
+  run("same hart", 1, 1);
+  run("two harts", 1, 2);
+  run("anywhere", ~0UL, ~0UL);
+  exit(0);
+}
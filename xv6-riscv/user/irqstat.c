@@ -0,0 +1,78 @@
+//
+// irqstat [-r]
+// print, for each hart, the histogram of how long it kept
+// interrupts off under push_off(), and the callers that kept
+// them off longest, worst first, with the lock they took. -r
+// clears the records afterwards, to start a new measurement.
+// look the pcs up in kernel/kernel.asm. needs a kernel built
+// with make IRQTRACE=1.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/irqstat.h"
+#include "user/user.h"
+
+#define US(t) ((t) / (TIMEBASE / 1000000))
+
+struct irqstat st;
+
+void
+show(int hart, struct irqcpu *ic)
+{
+  uint64 n = 0;
+  int order[NIRQWORST], nw = 0;
+
+  for(int i = 0; i < NIRQHIST; i++)
+    n += ic->hist[i];
+  if(n == 0)
+    return;
+
+  printf("hart %d: %lu stretches\n", hart, n);
+  for(int i = 0; i < NIRQHIST; i++){
+    if(ic->hist[i] == 0)
+      continue;
+    if(i == NIRQHIST - 1)
+      printf("  >= %d us\t%lu\n", 1 << i, ic->hist[i]);
+    else
+      printf("  %d-%d us\t%lu\n", i ? 1 << i : 0, 2 << i, ic->hist[i]);
+  }
+
+  // worst first.
+  for(int i = 0; i < NIRQWORST; i++){
+    if(ic->worst[i].pc == 0)
+      continue;
+    int j = nw++;
+    for(; j > 0 && ic->worst[order[j - 1]].cycles < ic->worst[i].cycles; j--)
+      order[j] = order[j - 1];
+    order[j] = i;
+  }
+  printf("  pc\t\tmax us\tlock\n");
+  for(int k = 0; k < nw; k++){
+    int i = order[k];
+    printf("  0x%lx\t%lu\t%s\n", ic->worst[i].pc,
+           US(ic->worst[i].cycles), ic->worst[i].lock);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int reset = 0;
+
+  if(argc > 1 && strcmp(argv[1], "-r") == 0)
+    reset = 1;
+  else if(argc > 1){
+    fprintf(2, "usage: irqstat [-r]\n");
+    exit(1);
+  }
+
+  if(irqstat(&st, reset) < 0){
+    fprintf(2, "irqstat: no records, build the kernel with make IRQTRACE=1\n");
+    exit(1);
+  }
+  for(int i = 0; i < NCPU; i++)
+    show(i, &st.cpu[i]);
+  exit(0);
+}
@@ -0,0 +1,48 @@
+//
+// mstat [pid...]
+// print the page-fault and memory counters of the given
+// processes, or of every process if none are given.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "kernel/pstat.h"
+#include "kernel/mstat.h"
+
+void
+show(int pid)
+{
+  struct mstat st;
+
+  if(getmstat(pid, &st) < 0){
+    fprintf(2, "mstat: no process %d\n", pid);
+    return;
+  }
+  printf("%d\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu\t%lu\n", st.pid,
+         st.minflt, st.majflt, st.cowcopy, st.cowreuse,
+         st.writeback, st.rss, st.shared);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct pstat info;
+
+  printf("pid\tminflt\tmajflt\tcowcopy\tcowreuse\twback\trss\tshared\n");
+  if(argc > 1){
+    for(int i = 1; i < argc; i++)
+      show(atoi(argv[i]));
+    exit(0);
+  }
+
+  if(getpinfo(&info) < 0){
+    fprintf(2, "mstat: getpinfo failed\n");
+    exit(1);
+  }
+  for(int i = 0; i < NPROC; i++)
+    if(info.inuse[i])
+      show(info.pid[i]);
+  exit(0);
+}
@@ -0,0 +1,92 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "user/user.h"
+
+// Mutexes and condition variables on top of futex(). They work
+// between threads, and between processes that share the page
+// they are in through a MAP_SHARED mapping. The fast paths
+// never enter the kernel.
+//
+// A mutex is 0 when free, 1 when held and 2 when held with
+// (maybe) someone asleep on it, after Drepper's "Futexes Are
+// Tricky". A condition variable is a counter that every signal
+// bumps, so that a waiter that would miss a signal between
+// dropping the mutex and falling asleep finds the counter
+// changed and does not sleep.
+
+void
+mutex_init(struct mutex *m)
+{
+  m->state = 0;
+}
+
+int
+mutex_trylock(struct mutex *m)
+{
+  int c = 0;
+
+  return __atomic_compare_exchange_n(&m->state, &c, 1, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+void
+mutex_lock(struct mutex *m)
+{
+  int c = 0;
+
+  if(__atomic_compare_exchange_n(&m->state, &c, 1, 0,
+                                 __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    return;
+  // contended: say so, and sleep until it is free.
+  if(c != 2)
+    c = __atomic_exchange_n(&m->state, 2, __ATOMIC_ACQUIRE);
+  while(c != 0){
+    futex(&m->state, FUTEX_WAIT, 2);
+    c = __atomic_exchange_n(&m->state, 2, __ATOMIC_ACQUIRE);
+  }
+}
+
+void
+mutex_unlock(struct mutex *m)
+{
+  if(__atomic_fetch_sub(&m->state, 1, __ATOMIC_RELEASE) != 1){
+    __atomic_store_n(&m->state, 0, __ATOMIC_RELEASE);
+    futex(&m->state, FUTEX_WAKE, 1);
+  }
+}
+
+void
+cond_init(struct cond *c)
+{
+  c->seq = 0;
+}
+
+// Wait for a signal on c. m must be held; it is dropped while
+// waiting and held again on return. Wakeups may be spurious.
+void
+cond_wait(struct cond *c, struct mutex *m)
+{
+  int seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+
+  mutex_unlock(m);
+  futex(&c->seq, FUTEX_WAIT, seq);
+  // others may be waiting for m as well: lock it as contended,
+  // so that our unlock wakes them.
+  while(__atomic_exchange_n(&m->state, 2, __ATOMIC_ACQUIRE) != 0)
+    futex(&m->state, FUTEX_WAIT, 2);
+}
+
+void
+cond_signal(struct cond *c)
+{
+  __atomic_fetch_add(&c->seq, 1, __ATOMIC_RELEASE);
+  futex(&c->seq, FUTEX_WAKE, 1);
+}
+
+void
+cond_broadcast(struct cond *c)
+{
+  __atomic_fetch_add(&c->seq, 1, __ATOMIC_RELEASE);
+  futex(&c->seq, FUTEX_WAKE, 0x7fffffff);
+}
@@ -0,0 +1,148 @@
+//
+// benchmark for the scheduler's time slice (setquantum()).
+// runs NSPIN CPU-bound spinners next to a pair of processes
+// bouncing a byte over pipes, once for each slice below,
+// and reports the spinners' throughput, the ping-pong round
+// trips (each needs the echo process to get a CPU away from
+// the spinners, so they measure latency) and the context
+// switches per second, from getpinfo(). a slice of 0 is the
+// scheduler's default, which is the adaptive one under
+// make ADAPTIVE=1.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/pstat.h"
+#include "user/user.h"
+
+#define NSPIN  8     // CPU-bound processes
+#define TICKS  30    // length of each measurement
+#define HZ     (TIMEBASE / QUANTUM)
+
+int slices[] = { 0, 5000, 20000, 100000, 400000 };   // us
+#define NSLICE ((int)(sizeof(slices) / sizeof(slices[0])))
+
+int pids[NSPIN + 2];
+struct pstat st;
+
+// count loops until ticks reaches end, report the count on
+// fd, and wait for go to be closed so that the parent can
+// read our counters before we exit.
+void
+spin(int end, int fd, int go)
+{
+  uint64 n = 0;
+  char c;
+
+  while(uptime() < end){
+    for(volatile int i = 0; i < 1000; i++)
+      ;
+    n++;
+  }
+  write(fd, &n, sizeof(n));
+  read(go, &c, 1);
+  exit(0);
+}
+
+// context switches of the processes in pids[0..n-1].
+int
+switches(int n)
+{
+  int sw = 0;
+
+  getpinfo(&st);
+  for(int i = 0; i < NPROC; i++)
+    for(int j = 0; j < n; j++)
+      if(st.inuse[i] && st.pid[i] == pids[j])
+        sw += st.nvcsw[i] + st.nivcsw[i];
+  return sw;
+}
+
+void
+run(int us)
+{
+  int res[2], go[2], ping[2], pong[2];
+  int end, trips = 0, sw0, sw;
+  uint64 loops = 0, n;
+  char c = 0;
+
+  if(pipe(res) < 0 || pipe(go) < 0 || pipe(ping) < 0 || pipe(pong) < 0){
+    printf("quantumbench: pipe failed\n");
+    exit(1);
+  }
+  if(setquantum(us) < 0){
+    printf("quantumbench: setquantum(%d) failed\n", us);
+    exit(1);
+  }
+  end = uptime() + TICKS;
+  // children inherit the slice.
+  for(int i = 0; i < NSPIN + 1; i++){
+    pids[i] = fork();
+    if(pids[i] < 0){
+      printf("quantumbench: fork failed\n");
+      exit(1);
+    }
+    if(pids[i] == 0){
+      close(go[1]);
+      if(i < NSPIN)
+        spin(end, res[1], go[0]);
+      // the echo process.
+      close(ping[1]);
+      close(pong[0]);
+      while(read(ping[0], &c, 1) == 1)
+        write(pong[1], &c, 1);
+      exit(0);
+    }
+  }
+  pids[NSPIN + 1] = getpid();
+  close(go[0]);
+  close(ping[0]);
+  close(pong[1]);
+
+  sw0 = switches(NSPIN + 2);
+  while(uptime() < end){
+    write(ping[1], &c, 1);
+    if(read(pong[0], &c, 1) != 1){
+      printf("quantumbench: short read\n");
+      exit(1);
+    }
+    trips++;
+  }
+  for(int i = 0; i < NSPIN; i++){
+    if(read(res[0], &n, sizeof(n)) != sizeof(n)){
+      printf("quantumbench: short read\n");
+      exit(1);
+    }
+    loops += n;
+  }
+  sw = switches(NSPIN + 2) - sw0;
+
+  close(go[1]);
+  close(ping[1]);
+  close(res[0]);
+  close(res[1]);
+  close(pong[0]);
+  for(int i = 0; i < NSPIN + 1; i++)
+    wait(0);
+  setquantum(0);
+
+  if(us)
+    printf("quantumbench: slice %d us:", us);
+  else
+    printf("quantumbench: default slice:");
+  printf(" %lu kloops/s, %d round trips/s, %d switches/s\n",
+         loops * HZ / TICKS, trips * HZ / TICKS, sw * HZ / TICKS);
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc > 1){
+    run(atoi(argv[1]));
+    exit(0);
+  }
+  for(int i = 0; i < NSLICE; i++)
+    run(slices[i]);
+  exit(0);
+}
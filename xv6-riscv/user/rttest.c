@@ -0,0 +1,84 @@
+//
+// show what the real-time band (setrtprio()) does for wakeup
+// latency. starts NSPIN CPU-bound processes, then a process
+// that sleeps for one tick at a time and records how many
+// ticks late each wakeup was, first at normal priority and
+// then at real-time level 1. at real-time level it should
+// never be more than one tick late.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+#define NSPIN   12
+#define ROUNDS  50
+
+int spinners[NSPIN];
+
+void
+spin(void)
+{
+  volatile int x = 0;
+
+  for(;;)
+    x++;
+}
+
+// sleep one tick at a time and report how late we woke up.
+// returns the worst lateness seen.
+int
+measure(char *what)
+{
+  int t0, late, worst = 0, sum = 0;
+
+  for(int i = 0; i < ROUNDS; i++){
+    t0 = uptime();
+    sleep(1);
+    late = uptime() - t0 - 1;
+    if(late < 0)
+      late = 0;
+    sum += late;
+    if(late > worst)
+      worst = late;
+  }
+  printf("rttest: %s: worst %d ticks late, %d late ticks in %d wakeups\n",
+         what, worst, sum, ROUNDS);
+  return worst;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int worst;
+
+  for(int i = 0; i < NSPIN; i++){
+    if((spinners[i] = fork()) < 0){
+      printf("rttest: fork failed\n");
+      exit(1);
+    }
+    if(spinners[i] == 0)
+      spin();
+  }
+
+  measure("normal");
+  if(setrtprio(1) < 0){
+    printf("rttest: setrtprio failed\n");
+    exit(1);
+  }
+  worst = measure("real-time");
+  setrtprio(0);
+
+  for(int i = 0; i < NSPIN; i++)
+    kill(spinners[i]);
+  for(int i = 0; i < NSPIN; i++)
+    wait(0);
+
+  if(worst > 1){
+    printf("rttest: FAIL\n");
+    exit(1);
+  }
+  printf("rttest: OK\n");
+  exit(0);
+}
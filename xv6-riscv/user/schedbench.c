@@ -0,0 +1,120 @@
+//
+// benchmark for the scheduler's decision path.
+// two processes bounce a byte over a pair of pipes, so
+// every round trip needs two trips through scheduler()
+// and two wakeup()s, while a number of filler processes
+// sit asleep on another pipe. reports round trips per
+// clock tick for an increasing number of fillers; rebuild
+// with make NPROC=n to see how the cost grows with NPROC.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+#define TICKS 100   // length of each measurement
+
+// fork n children that block reading the pipe p until its
+// write end is closed, which each child closes its copy of.
+void
+fill(int n, int p[2])
+{
+  char c;
+
+  for(int i = 0; i < n; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf("schedbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      close(p[1]);
+      read(p[0], &c, 1);
+      exit(0);
+    }
+  }
+}
+
+// count round trips between this process and a child
+// for TICKS ticks.
+int
+pingpong(void)
+{
+  int ping[2], pong[2];
+  int n, t0, pid;
+  char c = 0;
+
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    printf("schedbench: pipe failed\n");
+    exit(1);
+  }
+  pid = fork();
+  if(pid < 0){
+    printf("schedbench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit(0);
+  }
+  close(ping[0]);
+  close(pong[1]);
+
+  n = 0;
+  t0 = uptime();
+  while(uptime() - t0 < TICKS){
+    write(ping[1], &c, 1);
+    if(read(pong[0], &c, 1) != 1){
+      printf("schedbench: short read\n");
+      exit(1);
+    }
+    n++;
+  }
+  close(ping[1]);
+  close(pong[0]);
+  wait(0);
+  return n;
+}
+
+void
+run(int nfill)
+{
+  int p[2], n;
+
+  if(pipe(p) < 0){
+    printf("schedbench: pipe failed\n");
+    exit(1);
+  }
+  fill(nfill, p);
+  close(p[0]);
+
+  n = pingpong();
+  printf("schedbench: NPROC %d, %d sleeping: %d round trips/tick\n",
+         NPROC, nfill, n / TICKS);
+
+  // let the fillers go.
+  close(p[1]);
+  for(int i = 0; i < nfill; i++)
+    wait(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  // leave room for init, sh, ourselves and the ping-pong child.
+  int max = NPROC - 8;
+
+  if(argc > 1){
+    run(atoi(argv[1]));
+    exit(0);
+  }
+  run(0);
+  run(max / 4);
+  run(max / 2);
+  run(max);
+  exit(0);
+}
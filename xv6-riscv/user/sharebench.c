@@ -0,0 +1,114 @@
+//
+// compare how closely a proportional-share scheduler tracks
+// ticket shares over time. forks COPIES spinners in each of
+// the ticket classes below, then every INTERVAL ticks prints
+// the worst error of any single spinner's share of the ticks
+// so far against its share of the tickets. build once with
+// make LOTERY_SCHED=1 and once with make STRIDE_SCHED=1 and
+// compare: stride should settle quickly and stay near 0,
+// lottery should wander and only shrink slowly.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/pstat.h"
+#include "user/user.h"
+
+#define COPIES   4
+#define INTERVAL 10    // ticks between samples
+#define SAMPLES  30
+
+int classes[] = { 10, 20, 30 };
+#define NCLASS ((int)(sizeof(classes) / sizeof(classes[0])))
+
+int pids[NCLASS][COPIES];
+struct pstat st;
+
+void
+spin(void)
+{
+  volatile int x = 0;
+
+  for(;;)
+    x++;
+}
+
+// ticks getpinfo() reports for pid.
+int
+ticksof(int pid)
+{
+  for(int i = 0; i < NPROC; i++)
+    if(st.inuse[i] && st.pid[i] == pid)
+      return st.ticks[i];
+  return 0;
+}
+
+// worst error over all spinners, in tenths of a percent of
+// each spinner's expected ticks.
+int
+worst(int *total)
+{
+  int tickets = 0, sum = 0, err, max = 0;
+
+  getpinfo(&st);
+  for(int c = 0; c < NCLASS; c++){
+    tickets += COPIES * classes[c];
+    for(int i = 0; i < COPIES; i++)
+      sum += ticksof(pids[c][i]);
+  }
+  *total = sum;
+  if(sum == 0)
+    return 0;
+  for(int c = 0; c < NCLASS; c++){
+    for(int i = 0; i < COPIES; i++){
+      // expected ticks, scaled by tickets to stay in integers.
+      int want = sum * classes[c];
+      err = (ticksof(pids[c][i]) * tickets - want) * 1000 / want;
+      if(err < 0)
+        err = -err;
+      if(err > max)
+        max = err;
+    }
+  }
+  return max;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int t0, total, err;
+
+  for(int c = 0; c < NCLASS; c++){
+    // children inherit the tickets.
+    settickets(classes[c]);
+    for(int i = 0; i < COPIES; i++){
+      int pid = fork();
+      if(pid < 0){
+        printf("sharebench: fork failed\n");
+        exit(1);
+      }
+      if(pid == 0)
+        spin();
+      pids[c][i] = pid;
+    }
+  }
+  // outrank the spinners so that samples are taken on time.
+  settickets(MAXTICKETS);
+
+  t0 = uptime();
+  for(int s = 1; s <= SAMPLES; s++){
+    sleep(INTERVAL);
+    err = worst(&total);
+    printf("sharebench: %d ticks, %d picks: worst share error %d.%d%%\n",
+           uptime() - t0, total, err / 10, err % 10);
+  }
+
+  for(int c = 0; c < NCLASS; c++)
+    for(int i = 0; i < COPIES; i++)
+      kill(pids[c][i]);
+  for(int c = 0; c < NCLASS; c++)
+    for(int i = 0; i < COPIES; i++)
+      wait(0);
+  exit(0);
+}
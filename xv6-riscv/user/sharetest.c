@@ -0,0 +1,129 @@
+//
+// test that the lottery scheduler (make LOTERY_SCHED=1) gives
+// CPU-bound processes time in proportion to their tickets,
+// even though every hart draws from its own run queue.
+// forks COPIES spinners in each of the ticket classes below,
+// lets them run, and compares the ticks getpinfo() reports
+// for each class with its share of the tickets, then runs a
+// chi-square test of the ticks of every single process against
+// its ticket share.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/pstat.h"
+#include "user/user.h"
+
+#define COPIES  6     // spinners per class
+#define TICKS   300   // how long to let them run
+#define MAXERR  20    // allowed error per class, percent
+// chi-square critical value for NCLASS*COPIES-1 = 17 degrees
+// of freedom at the 0.1% level.
+#define CHI2MAX 41
+
+int classes[] = { 10, 20, 30 };
+#define NCLASS ((int)(sizeof(classes) / sizeof(classes[0])))
+
+int pids[NCLASS][COPIES];
+int ticks[NCLASS][COPIES];
+struct pstat st;
+
+void
+spin(void)
+{
+  volatile int x = 0;
+
+  for(;;)
+    x++;
+}
+
+// ticks getpinfo() reports for pid.
+int
+ticksof(int pid)
+{
+  for(int i = 0; i < NPROC; i++)
+    if(st.inuse[i] && st.pid[i] == pid)
+      return st.ticks[i];
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int total = 0, tickets = 0, fail = 0, chi2 = 0;
+  int got[NCLASS];
+
+  for(int c = 0; c < NCLASS; c++){
+    // children inherit the tickets, so they have the
+    // right number from their very first run.
+    settickets(classes[c]);
+    for(int i = 0; i < COPIES; i++){
+      int pid = fork();
+      if(pid < 0){
+        printf("sharetest: fork failed\n");
+        exit(1);
+      }
+      if(pid == 0)
+        spin();
+      pids[c][i] = pid;
+    }
+    tickets += COPIES * classes[c];
+  }
+
+  sleep(TICKS);
+  getpinfo(&st);
+
+  for(int c = 0; c < NCLASS; c++){
+    got[c] = 0;
+    for(int i = 0; i < COPIES; i++){
+      ticks[c][i] = ticksof(pids[c][i]);
+      got[c] += ticks[c][i];
+      kill(pids[c][i]);
+    }
+    total += got[c];
+  }
+  for(int c = 0; c < NCLASS; c++)
+    for(int i = 0; i < COPIES; i++)
+      wait(0);
+
+  if(total == 0){
+    printf("sharetest: no ticks recorded\n");
+    exit(1);
+  }
+  for(int c = 0; c < NCLASS; c++){
+    // expected ticks for this class, and how far off it was.
+    int want = total * COPIES * classes[c] / tickets;
+    int err = (got[c] - want) * 100 / want;
+    if(err < 0)
+      err = -err;
+    printf("sharetest: %d tickets: %d ticks, expected %d (%d%% off)\n",
+           classes[c], got[c], want, err);
+    if(err > MAXERR)
+      fail = 1;
+  }
+  if(fail){
+    printf("sharetest: FAIL, some class is more than %d%% off\n", MAXERR);
+    exit(1);
+  }
+
+  // sum of (observed - expected)^2 / expected over all
+  // processes, kept in hundredths.
+  for(int c = 0; c < NCLASS; c++){
+    int want = total * classes[c] / tickets;
+    if(want == 0)
+      want = 1;
+    for(int i = 0; i < COPIES; i++){
+      int d = ticks[c][i] - want;
+      chi2 += d * d * 100 / want;
+    }
+  }
+  printf("sharetest: chi-square %d.%d%d over %d processes\n",
+         chi2 / 100, chi2 / 10 % 10, chi2 % 10, NCLASS * COPIES);
+  if(chi2 > CHI2MAX * 100){
+    printf("sharetest: FAIL, chi-square above %d\n", CHI2MAX);
+    exit(1);
+  }
+  printf("sharetest: OK\n");
+  exit(0);
+}
@@ -0,0 +1,69 @@
+//
+// timed sleep: check that msleep() keeps time, and show that
+// sleeping processes no longer cost anything while they sleep.
+// a CPU-bound loop is timed alone and then again while NSLEEP
+// processes sleep; when every sleeper was woken on every tick
+// the loop lost time to them, now it should not.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+#define NSLEEP  60
+#define TICKS   50     // length of each loop measurement
+#define MS      50     // msleep() length, and
+#define NMS     20     // how many of them
+
+int sleepers[NSLEEP];
+
+// iterations of an empty loop per tick.
+int
+loop(void)
+{
+  volatile int x;
+  int n = 0, t0;
+
+  t0 = uptime();
+  while(uptime() - t0 < TICKS){
+    for(x = 0; x < 10000; x++)
+      ;
+    n++;
+  }
+  return n / TICKS;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int t0, alone, busy;
+
+  t0 = uptime();
+  for(int i = 0; i < NMS; i++)
+    msleep(MS);
+  printf("sleeptest: %d x msleep(%d) took %d ticks, expected %d\n",
+         NMS, MS, uptime() - t0, NMS * MS / 100);
+
+  alone = loop();
+
+  for(int i = 0; i < NSLEEP; i++){
+    if((sleepers[i] = fork()) < 0){
+      printf("sleeptest: fork failed\n");
+      exit(1);
+    }
+    if(sleepers[i] == 0){
+      sleep(100000);
+      exit(0);
+    }
+  }
+  busy = loop();
+  for(int i = 0; i < NSLEEP; i++)
+    kill(sleepers[i]);
+  for(int i = 0; i < NSLEEP; i++)
+    wait(0);
+
+  printf("sleeptest: loop alone: %d/tick, with %d sleepers: %d/tick\n",
+         alone, NSLEEP, busy);
+  exit(0);
+}
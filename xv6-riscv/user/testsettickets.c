@@ -58,7 +58,9 @@ int main(int argc, char *argv[]){
     getpinfo(&info); //Se pasa la dirección de pstat en el espacio de usuario
     for(int i=0; i<NPROC; i++){
       if(info.inuse[i] == 1){
-        printf("pid: %d; tickets: %d; ticks: %d;\n", info.pid[i], info.tickets[i], info.ticks[i]);
+        // + DEISO - P3
+        printf("pid: %d; tickets: %d; ticks: %d; used: %d%%;\n", info.pid[i], info.tickets[i], info.ticks[i], info.used[i]);
+        // - DEISO - P3
       }
     }
   }
@@ -0,0 +1,77 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+// Threads on top of clone() and join(). Each thread runs on a
+// stack from malloc(), which thread_join() frees again. Like
+// malloc() itself, these are not thread-safe: call them from
+// one thread at a time.
+
+#define TSTACK 8192
+
+struct thread {
+  void (*fn)(void *);
+  void *arg;
+};
+
+// stacks of the threads not yet joined, by pid.
+static struct {
+  int tid;
+  char *stack;
+} threads[NTHREAD];
+
+static void
+start(void *a)
+{
+  struct thread *t = a;
+
+  t->fn(t->arg);
+  exit(0);
+}
+
+// Start a thread running fn(arg). Returns its pid, or -1.
+int
+thread_create(void (*fn)(void *), void *arg)
+{
+  struct thread *t;
+  char *stack;
+  int i, tid;
+
+  for(i = 0; i < NTHREAD; i++)
+    if(threads[i].stack == 0)
+      break;
+  if(i == NTHREAD)
+    return -1;
+  if((stack = malloc(TSTACK)) == 0)
+    return -1;
+
+  // fn and arg go at the bottom of the stack.
+  t = (struct thread *)stack;
+  t->fn = fn;
+  t->arg = arg;
+  if((tid = clone(start, t, stack + TSTACK)) < 0){
+    free(stack);
+    return -1;
+  }
+  threads[i].tid = tid;
+  threads[i].stack = stack;
+  return tid;
+}
+
+// Wait for thread tid, or any if tid is -1, to return, and
+// free its stack. Returns its pid, or -1 if there is none.
+int
+thread_join(int tid)
+{
+  if((tid = join(tid)) < 0)
+    return -1;
+  for(int i = 0; i < NTHREAD; i++){
+    if(threads[i].stack && threads[i].tid == tid){
+      free(threads[i].stack);
+      threads[i].stack = 0;
+      break;
+    }
+  }
+  return tid;
+}
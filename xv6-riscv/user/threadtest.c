@@ -0,0 +1,262 @@
+//
+// test clone() and join(), through thread_create() and
+// thread_join(): threads share memory, sbrk() and files, and
+// run at once on several harts; wait() leaves them to join();
+// fork() from a thread with others running gives the child a
+// copy-on-write snapshot the threads cannot write into, and
+// does not lose a futex() wake for a thread asleep across it;
+// a process ends with its first thread, threads and all; and a
+// process may have no more than NTHREAD threads at a time.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/fcntl.h"
+#include "user/user.h"
+
+#define NT    4         // threads for the sharing tests
+#define LOOPS 100000
+
+volatile int counts[NT];
+volatile int go;
+volatile int stop;
+volatile char *grown;
+int word;
+volatile int woke;
+int fds[2];
+
+void
+fail(char *why)
+{
+  printf("threadtest: FAIL, %s\n", why);
+  exit(1);
+}
+
+// count up in our own slot of counts[].
+void
+counter(void *arg)
+{
+  int i = (int)(uint64)arg;
+
+  while(!go)
+    ;
+  for(int n = 0; n < LOOPS; n++)
+    counts[i]++;
+}
+
+// grow the memory, and make a pipe for the creator to use.
+void
+grower(void *arg)
+{
+  char *p = sbrk(4096);
+
+  if(p == (char *)-1)
+    return;
+  p[0] = 'x';
+  grown = p;
+  if(pipe(fds) < 0)
+    grown = 0;
+}
+
+// keep writing to counts[0] until told to stop.
+void
+writer(void *arg)
+{
+  while(!stop)
+    counts[0]++;
+}
+
+// sleep in futex() until word is set.
+void
+waiter(void *arg)
+{
+  while(__atomic_load_n(&word, __ATOMIC_SEQ_CST) == 0)
+    futex(&word, FUTEX_WAIT, 0);
+  woke = 1;
+}
+
+// wait until told to stop.
+void
+idler(void *arg)
+{
+  while(!stop)
+    sleep(1);
+}
+
+void
+shared(void)
+{
+  int tids[NT];
+
+  go = 0;
+  for(int i = 0; i < NT; i++){
+    counts[i] = 0;
+    if((tids[i] = thread_create(counter, (void *)(uint64)i)) < 0)
+      fail("thread_create");
+  }
+  go = 1;
+  for(int i = 0; i < NT; i++)
+    if(thread_join(tids[i]) != tids[i])
+      fail("thread_join returned the wrong thread");
+  for(int i = 0; i < NT; i++)
+    if(counts[i] != LOOPS)
+      fail("a thread's writes were lost");
+  if(join(-1) != -1)
+    fail("join with no threads left");
+  printf("threadtest: shared memory OK\n");
+}
+
+void
+growth(void)
+{
+  char c;
+
+  grown = 0;
+  if(thread_join(thread_create(grower, 0)) < 0)
+    fail("thread_join");
+  if(grown == 0 || grown[0] != 'x')
+    fail("the thread's sbrk() is not ours");
+  if(write(fds[1], "y", 1) != 1 || read(fds[0], &c, 1) != 1 || c != 'y')
+    fail("the thread's pipe is not ours");
+  close(fds[0]);
+  close(fds[1]);
+  printf("threadtest: sbrk and files OK\n");
+}
+
+void
+waitjoin(void)
+{
+  int tid;
+
+  stop = 0;
+  if((tid = thread_create(idler, 0)) < 0)
+    fail("thread_create");
+  if(wait(0) != -1)
+    fail("wait() reaped a thread");
+  char *argv[] = { "echo", 0 };
+  if(exec("echo", argv) != -1)
+    fail("exec() with a thread running");
+  stop = 1;
+  if(thread_join(-1) != tid)
+    fail("thread_join(-1)");
+  printf("threadtest: wait, join and exec OK\n");
+}
+
+void
+forked(void)
+{
+  int tid, pid, status;
+
+  stop = 0;
+  counts[0] = 0;
+  if((tid = thread_create(writer, 0)) < 0)
+    fail("thread_create");
+  while(counts[0] == 0)
+    ;
+  pid = fork();
+  if(pid < 0)
+    fail("fork");
+  if(pid == 0){
+    // our copy of counts[0] must stand still.
+    int n = counts[0];
+    sleep(5);
+    exit(counts[0] != n);
+  }
+  sleep(2);
+  stop = 1;
+  thread_join(tid);
+  if(wait(&status) != pid || status != 0)
+    fail("a thread wrote into the child");
+  printf("threadtest: fork OK\n");
+}
+
+// a fork() while a thread sleeps on word makes word's page
+// copy-on-write; setting word then moves it to a new page, and
+// the wake must still find the sleeper.
+void
+futexfork(void)
+{
+  int tid, pid, t0;
+
+  word = 0;
+  woke = 0;
+  if((tid = thread_create(waiter, 0)) < 0)
+    fail("thread_create");
+  sleep(2);
+  pid = fork();
+  if(pid < 0)
+    fail("fork");
+  if(pid == 0)
+    exit(0);
+  wait(0);
+  __atomic_store_n(&word, 1, __ATOMIC_SEQ_CST);
+  futex(&word, FUTEX_WAKE, 1);
+  t0 = uptime();
+  while(!woke && uptime() - t0 < 50)
+    sleep(1);
+  if(!woke)
+    fail("futex wake lost across fork");
+  thread_join(tid);
+  printf("threadtest: futex across fork OK\n");
+}
+
+// a child whose first thread exits while another still runs
+// must be gone, files closed, by the time wait() returns.
+void
+groupexit(void)
+{
+  int p[2], pid;
+  char c;
+
+  if(pipe(p) < 0)
+    fail("pipe");
+  pid = fork();
+  if(pid < 0)
+    fail("fork");
+  if(pid == 0){
+    close(p[0]);
+    stop = 0;
+    if(thread_create(idler, 0) < 0)
+      exit(1);
+    exit(0);
+  }
+  close(p[1]);
+  if(wait(0) != pid)
+    fail("wait");
+  if(read(p[0], &c, 1) != 0)
+    fail("a thread outlived its process");
+  close(p[0]);
+  printf("threadtest: exit OK\n");
+}
+
+void
+limit(void)
+{
+  int n = 0;
+
+  stop = 0;
+  while(thread_create(idler, 0) >= 0)
+    n++;
+  stop = 1;
+  while(thread_join(-1) >= 0)
+    ;
+  // we hold one slot ourselves.
+  if(n != NTHREAD - 1)
+    fail("wrong number of threads");
+  printf("threadtest: %d threads OK\n", n + 1);
+}
+
+int
+main(int argc, char *argv[])
+{
+  shared();
+  growth();
+  waitjoin();
+  forked();
+  futexfork();
+  groupexit();
+  limit();
+  printf("threadtest: OK\n");
+  exit(0);
+}
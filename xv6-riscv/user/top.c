@@ -0,0 +1,141 @@
+//
+// top [-n count] [ticks]
+// every ticks clock ticks, 10 by default, print how each hart
+// spent the interval, in percent of it: running processes in
+// user space and in the kernel, in scheduler(), and idle. then
+// list the processes that ran most in the interval, with the
+// percent of a hart they used and their total user and system
+// time. stops after count reports, 1 by default, or never if
+// count is 0. keeps its own copy of the process table, which
+// procstat() brings up to date with just the slots that changed.
+//
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/cpustat.h"
+#include "kernel/procinfo.h"
+#include "user/user.h"
+
+#define NSHOW  10    // processes listed
+#define NBATCH 16    // slots brought over per procstat()
+#define MS(t) ((t) / (TIMEBASE / 1000))
+
+char *states[] = { "unused", "used", "sleep", "runble", "run", "zombie" };
+
+struct cpustat cs[2];
+struct procinfo tab[NPROC];
+struct procinfo batch[NBATCH];
+struct procquery q;
+int order[NPROC];
+uint64 used[NPROC];     // CPU time in the last interval
+
+// bring tab up to date, and work out used.
+void
+poll(void)
+{
+  int n;
+
+  for(int i = 0; i < NPROC; i++)
+    used[i] = 0;
+  q.since = q.now;
+  q.slot = 0;
+  do {
+    if((n = procstat(&q, batch, NBATCH)) < 0){
+      fprintf(2, "top: cannot read the process table\n");
+      exit(1);
+    }
+    for(int k = 0; k < n; k++){
+      struct procinfo *pi = &batch[k], *t = &tab[pi->slot];
+      used[pi->slot] = pi->utime + pi->stime;
+      if(t->state != 0 && t->pid == pi->pid)
+        used[pi->slot] -= t->utime + t->stime;
+      *t = *pi;
+    }
+  } while(q.slot >= 0);
+}
+
+void
+sample(int i)
+{
+  if(getcpustat(&cs[i]) < 0){
+    fprintf(2, "top: cannot read the statistics\n");
+    exit(1);
+  }
+  poll();
+}
+
+// percent of dt that t is.
+int
+pct(uint64 t, uint64 dt)
+{
+  return t * 100 / dt;
+}
+
+// the interval from sample a to sample b.
+void
+report(int a, int b)
+{
+  uint64 dt = cs[b].now - cs[a].now;
+  int n = 0;
+
+  if(dt == 0)
+    dt = 1;
+  printf("hart\tusr%%\tsys%%\tsched%%\tidle%%\tticks\n");
+  for(int i = 0; i < NCPU; i++){
+    if(!cs[b].cpu[i].online)
+      continue;
+    int usr = pct(cs[b].cpu[i].utime - cs[a].cpu[i].utime, dt);
+    int sys = pct(cs[b].cpu[i].stime - cs[a].cpu[i].stime, dt);
+    int idle = pct(cs[b].cpu[i].idle - cs[a].cpu[i].idle, dt);
+    int sched = 100 - usr - sys - idle;
+    printf("%d\t%d\t%d\t%d\t%d\t%d\n", i, usr, sys,
+           sched < 0 ? 0 : sched, idle,
+           cs[b].cpu[i].ticks - cs[a].cpu[i].ticks);
+  }
+
+  // busiest first.
+  for(int i = 0; i < NPROC; i++){
+    if(tab[i].state == 0)
+      continue;
+    int j = n++;
+    for(; j > 0 && used[order[j - 1]] < used[i]; j--)
+      order[j] = order[j - 1];
+    order[j] = i;
+  }
+  printf("\npid\tname\tstate\tcpu%%\thart\tusr ms\tsys ms\trss\n");
+  for(int k = 0; k < n && k < NSHOW; k++){
+    struct procinfo *t = &tab[order[k]];
+    printf("%d\t%s\t%s\t%d\t%d\t%lu\t%lu\t%lu\n", t->pid, t->name,
+           states[t->state], pct(used[order[k]], dt), t->cpu,
+           MS(t->utime), MS(t->stime), t->rss);
+  }
+  printf("\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  int count = 1, ticks = 10, i = 1;
+
+  if(i + 1 < argc && strcmp(argv[i], "-n") == 0){
+    count = atoi(argv[i + 1]);
+    i += 2;
+  }
+  if(i < argc)
+    ticks = atoi(argv[i++]);
+  if(i < argc || ticks <= 0){
+    fprintf(2, "usage: top [-n count] [ticks]\n");
+    exit(1);
+  }
+
+  q.version = PROCINFO_VERSION;
+  q.flags = PS_MEM;
+  sample(0);
+  for(int n = 0; count == 0 || n < count; n++){
+    sleep(ticks);
+    sample((n + 1) % 2);
+    report(n % 2, (n + 1) % 2);
+  }
+  exit(0);
+}
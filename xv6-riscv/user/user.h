@@ -4,6 +4,15 @@ struct stat;
 struct pstat;
 // - DEISO - P1
 
+// + DEISO - P3
+struct mstat;
+struct gstat;
+struct cpustat;
+struct procquery;
+struct procinfo;
+struct irqstat;
+// - DEISO - P3
+
 // system calls
 int fork(void);
 int exit(int) __attribute__((noreturn));
@@ -37,6 +46,23 @@ void *mmap(void *addr, uint64 length, int prot, int flags, int fd, int offset);
 int munmap(void *addr, uint64 length);
 // - DEISO - P2
 
+// + DEISO - P3
+int setstacklimit(int);
+int getmstat(int, struct mstat*);
+int setrtprio(int);
+int mkgroup(int);
+int getgstat(int, struct gstat*);
+int msleep(int);
+int setquantum(int);
+int clone(void (*)(void *), void *, void *);
+int join(int);
+int futex(int *, int, int);
+int setaffinity(int, uint64);
+int getcpustat(struct cpustat*);
+int procstat(struct procquery*, struct procinfo*, int);
+int irqstat(struct irqstat*, int);
+// - DEISO - P3
+
 // ulib.c
 int stat(const char*, struct stat*);
 char* strcpy(char*, const char*);
@@ -55,3 +81,25 @@ void *memcpy(void *, const void *, uint);
 // umalloc.c
 void* malloc(uint);
 void free(void*);
+
+// + DEISO - P3
+// thread.c
+int thread_create(void (*)(void *), void *);
+int thread_join(int);
+
+// mutex.c
+struct mutex {
+  int state;
+};
+struct cond {
+  int seq;
+};
+void mutex_init(struct mutex*);
+int mutex_trylock(struct mutex*);
+void mutex_lock(struct mutex*);
+void mutex_unlock(struct mutex*);
+void cond_init(struct cond*);
+void cond_wait(struct cond*, struct mutex*);
+void cond_signal(struct cond*);
+void cond_broadcast(struct cond*);
+// - DEISO - P3
@@ -2414,7 +2414,11 @@ stacktest(char *s)
   pid = fork();
   if(pid == 0) {
     char *sp = (char *) r_sp();
-    sp -= USERSTACK*PGSIZE;
+    // + DEISO - P3
+    // the stack grows on demand, so go below
+    // the most it may grow to.
+    sp -= USERSTACKLIMIT*PGSIZE;
+    // - DEISO - P3
     // the *sp should cause a trap.
     printf("%s: stacktest: read below stack %d\n", s, *sp);
     exit(1);
@@ -2429,6 +2433,72 @@ stacktest(char *s)
     exit(xstatus);
 }
 
+// + DEISO - P3
+int
+stackgrow_recurse(int n)
+{
+  volatile int buf[128];
+
+  buf[0] = n;
+  if(n == 0)
+    return 0;
+  return stackgrow_recurse(n - 1) + buf[0];
+}
+
+int
+stackgrow_forever(int n)
+{
+  volatile int buf[128];
+
+  buf[0] = n;
+  // never true, but the compiler cannot tell, so it neither
+  // rejects the recursion nor turns it into a loop.
+  if(buf[0] < 0)
+    return 0;
+  return stackgrow_forever(n + 1) + buf[0];
+}
+
+// the user stack starts out one page long and grows
+// on demand; recursing past the limit gets the
+// process killed rather than overwriting memory.
+void
+stackgrow(char *s)
+{
+  int pid;
+  int xstatus;
+  int n = 200; // about 100KB of stack, well under USERSTACKLIMIT
+
+  pid = fork();
+  if(pid == 0){
+    if(stackgrow_recurse(n) != n*(n+1)/2){
+      printf("%s: deep recursion returned a wrong result\n", s);
+      exit(1);
+    }
+    exit(0);
+  } else if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  wait(&xstatus);
+  if(xstatus != 0)
+    exit(xstatus);
+
+  pid = fork();
+  if(pid == 0){
+    stackgrow_forever(0);
+    exit(1);
+  } else if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  wait(&xstatus);
+  if(xstatus != -1){
+    printf("%s: stack overflow not caught\n", s);
+    exit(1);
+  }
+}
+// - DEISO - P3
+
 // check that writes to a few forbidden addresses
 // cause a fault, e.g. process's text and TRAMPOLINE.
 void
@@ -2644,6 +2714,9 @@ struct test {
   {bigargtest, "bigargtest"},
   {argptest, "argptest"},
   {stacktest, "stacktest"},
+  // + DEISO - P3
+  {stackgrow, "stackgrow"},
+  // - DEISO - P3
   {nowrite, "nowrite"},
   {pgbug, "pgbug" },
   {sbrkbugs, "sbrkbugs" },
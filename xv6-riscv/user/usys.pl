@@ -45,4 +45,21 @@ entry("getpinfo");
 # + DEISO - P2
 entry("mmap");
 entry("munmap");
-# - DEISO - P2
\ No newline at end of file
+# - DEISO - P2
+
+# + DEISO - P3
+entry("setstacklimit");
+entry("getmstat");
+entry("setrtprio");
+entry("mkgroup");
+entry("getgstat");
+entry("msleep");
+entry("setquantum");
+entry("clone");
+entry("join");
+entry("futex");
+entry("setaffinity");
+entry("getcpustat");
+entry("procstat");
+entry("irqstat");
+# - DEISO - P3